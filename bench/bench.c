@@ -0,0 +1,574 @@
+/**
+ * Benchmarks of libtvio.
+ *
+ * Measures the throughput and latency of CALL, CALL-ALL, TRIGGER,
+ * EMIT/listen and property observation for a range of payload sizes and
+ * caller threads. Every configuration prints one JSON object per line to
+ * stdout, progress goes to stderr.
+ *
+ * Usage: bench [--transport local|process] [--seconds s] [--sizes a,b,...]
+ *              [--threads a,b,...] [--benchmarks call,callall,trigger,emit,observe]
+ *
+ * With --transport process (the default) the output runs in a child process
+ * and all messages cross the loopback network, or the shared memory
+ * transport if TVIO_SHM=1 is set. With --transport local input and output
+ * live in the same process.
+ */
+#include "tvio.h"
+#include "thingiverseio.h"
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+char * const DESCRIPTOR = "function Echo(Data string) (Data string)\n"
+			  "function Trigger(Data string) (Data string)\n"
+			  "function Tick(Data string) (Data string)\n"
+			  "function Publish(Count int, Size int) (Done bool)\n"
+			  "function Change(Count int, Size int) (Done bool)\n"
+			  "property Value: Data string";
+
+#define SERVER_THREADS 4
+#define WAIT_MS 10000
+#define MAX_LIST 16
+#define TRANSIT_BYTES (64 << 20)
+
+static const char *transport = "loopback";
+static double seconds = 2;
+static int sizes[MAX_LIST] = {16, 256, 4096, 65536, 1 << 20, 4 << 20};
+static int n_sizes = 6;
+static int threads[MAX_LIST] = {1, 4, 16, 64};
+static int n_threads = 4;
+static const char *benchmarks = "call,callall,trigger,emit,observe";
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Payloads start with the time they were sent, which works across
+ * processes since CLOCK_MONOTONIC is system wide. */
+static void stamp(char *payload) {
+	uint64_t t = now_ns();
+	memcpy(payload, &t, sizeof(t));
+}
+
+static uint64_t since_stamp(const void *payload) {
+	uint64_t t;
+	memcpy(&t, payload, sizeof(t));
+	return now_ns() - t;
+}
+
+typedef struct {
+	uint64_t *v;
+	size_t n;
+	size_t cap;
+} samples;
+
+static void samples_add(samples *s, uint64_t x) {
+	if (s->n == s->cap) {
+		s->cap = s->cap ? 2 * s->cap : 1024;
+		s->v = realloc(s->v, s->cap * sizeof(uint64_t));
+	}
+	s->v[s->n++] = x;
+}
+
+static void samples_merge(samples *dst, samples *src) {
+	for (size_t k = 0; k < src->n; k++) {
+		samples_add(dst, src->v[k]);
+	}
+	free(src->v);
+	memset(src, 0, sizeof(*src));
+}
+
+static int cmp_u64(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+static double percentile_us(samples *s, double q) {
+	if (s->n == 0) {
+		return 0;
+	}
+	size_t k = (size_t)(q * (s->n - 1) + 0.5);
+	return s->v[k] / 1000.0;
+}
+
+static void report(const char *bench, int size, int n, uint64_t ops, uint64_t lost, uint64_t elapsed, samples *lat) {
+	double secs = elapsed / 1e9;
+	int maj, min, fix;
+	version(&maj, &min, &fix);
+	qsort(lat->v, lat->n, sizeof(uint64_t), cmp_u64);
+	printf("{\"bench\":\"%s\",\"transport\":\"%s\",\"version\":\"%d.%d.%d\",\"size\":%d,\"threads\":%d,"
+	       "\"ops\":%llu,\"lost\":%llu,\"seconds\":%.3f,\"ops_per_sec\":%.1f,\"mb_per_sec\":%.2f,"
+	       "\"p50_us\":%.2f,\"p99_us\":%.2f,\"p999_us\":%.2f}\n",
+	       bench, transport, maj, min, fix, size, n,
+	       (unsigned long long)ops, (unsigned long long)lost, secs,
+	       secs > 0 ? ops / secs : 0, secs > 0 ? ops * (double)size / secs / (1 << 20) : 0,
+	       percentile_us(lat, 0.5), percentile_us(lat, 0.99), percentile_us(lat, 0.999));
+	fflush(stdout);
+	free(lat->v);
+	memset(lat, 0, sizeof(*lat));
+}
+
+/* Output side */
+
+static volatile sig_atomic_t stopping;
+
+static void on_term(int sig) {
+	stopping = 1;
+}
+
+/* serve echoes every request. Publish and Change requests are answered
+ * right away and then emit Count results or property changes of Size
+ * bytes. */
+static void *serve(void *arg) {
+	int output = *(int *)arg;
+	while (!stopping) {
+		int is;
+		if (output_request_wait(output, 100, &is) != 0) {
+			break;
+		}
+		char *id, *function;
+		void *params;
+		int params_size;
+		if (!is || output_request_take(output, &id, &function, &params, &params_size) != 0) {
+			continue;
+		}
+		int publish = strcmp(function, "Publish") == 0;
+		if ((publish || strcmp(function, "Change") == 0) && params_size == 2 * sizeof(int64_t)) {
+			int64_t count, size;
+			memcpy(&count, params, sizeof(count));
+			memcpy(&size, (char *)params + sizeof(count), sizeof(size));
+			char done = 1;
+			output_reply(output, id, &done, 1);
+			char *payload = calloc(1, size);
+			for (int64_t k = 0; k < count && !stopping; k++) {
+				stamp(payload);
+				if (publish) {
+					output_emit(output, "Tick", payload, sizeof(uint64_t), payload, size);
+				} else {
+					output_property_set(output, "Value", payload, size);
+				}
+			}
+			free(payload);
+		} else {
+			output_reply(output, id, params, params_size);
+		}
+		free(id);
+	}
+	return NULL;
+}
+
+static pthread_t servers[SERVER_THREADS];
+
+static int start_output(void) {
+	static int output;
+	output = new_output(DESCRIPTOR);
+	if (output < 0) {
+		return output;
+	}
+	for (int k = 0; k < SERVER_THREADS; k++) {
+		pthread_create(&servers[k], NULL, serve, &output);
+	}
+	return output;
+}
+
+static void stop_output(int output) {
+	stopping = 1;
+	for (int k = 0; k < SERVER_THREADS; k++) {
+		pthread_join(servers[k], NULL);
+	}
+	output_remove(output);
+}
+
+static int run_server(void) {
+	signal(SIGTERM, on_term);
+	int output = start_output();
+	if (output < 0) {
+		fprintf(stderr, "failed to create output: %d\n", output);
+		return 1;
+	}
+	while (!stopping) {
+		pause();
+	}
+	stop_output(output);
+	return 0;
+}
+
+/* Input side */
+
+typedef struct {
+	int input;
+	int size;
+	uint64_t deadline;
+	uint64_t ops;
+	uint64_t lost;
+	samples lat;
+} worker;
+
+static void *call_worker(void *arg) {
+	worker *w = arg;
+	char *payload = calloc(1, w->size);
+	char *buf = malloc(w->size);
+	while (now_ns() < w->deadline) {
+		uint64_t start = now_ns();
+		char *id;
+		int id_size, ready = 0, size;
+		if (input_call(w->input, "Echo", payload, w->size, &id, &id_size) != 0) {
+			w->lost++;
+			continue;
+		}
+		input_call_result_wait(w->input, id, WAIT_MS, &ready);
+		if (ready && input_call_result_params_into(w->input, id, buf, w->size, &size) == 0) {
+			samples_add(&w->lat, now_ns() - start);
+			w->ops++;
+		} else {
+			w->lost++;
+		}
+		free(id);
+	}
+	free(payload);
+	free(buf);
+	return NULL;
+}
+
+static void *call_all_worker(void *arg) {
+	worker *w = arg;
+	char *payload = calloc(1, w->size);
+	char *buf = malloc(w->size);
+	tvio_poll_item item = {w->input, TVIO_POLL_INPUT, 0};
+	while (now_ns() < w->deadline) {
+		uint64_t start = now_ns();
+		char *id;
+		int id_size, is = 0, size, n_ready;
+		if (input_call_all(w->input, "Echo", payload, w->size, &id, &id_size) != 0) {
+			w->lost++;
+			continue;
+		}
+		while (input_call_all_next_result_available(w->input, id, &is) == 0 && !is &&
+		       now_ns() - start < WAIT_MS * 1000000ULL) {
+			poll_handles(&item, 1, 10, &n_ready);
+		}
+		if (is && input_call_all_next_result_params_into(w->input, id, buf, w->size, &size) == 0) {
+			samples_add(&w->lat, now_ns() - start);
+			w->ops++;
+			input_call_all_next_result_clear(w->input, id);
+		} else {
+			w->lost++;
+		}
+		input_call_all_request_clear(w->input, id);
+		free(id);
+	}
+	free(payload);
+	free(buf);
+	return NULL;
+}
+
+/* Triggers in flight are bounded, so fast senders do not queue up
+ * unbounded amounts of data. */
+static pthread_mutex_t transit_m = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t transit_c = PTHREAD_COND_INITIALIZER;
+static long transit, transit_max;
+
+static void *trigger_worker(void *arg) {
+	worker *w = arg;
+	char *payload = calloc(1, w->size);
+	while (now_ns() < w->deadline) {
+		pthread_mutex_lock(&transit_m);
+		while (transit >= transit_max) {
+			pthread_cond_wait(&transit_c, &transit_m);
+		}
+		transit++;
+		pthread_mutex_unlock(&transit_m);
+		stamp(payload);
+		if (input_trigger(w->input, "Trigger", payload, w->size) == 0) {
+			w->ops++;
+		}
+	}
+	free(payload);
+	return NULL;
+}
+
+static void transit_done(void) {
+	pthread_mutex_lock(&transit_m);
+	transit--;
+	pthread_cond_signal(&transit_c);
+	pthread_mutex_unlock(&transit_m);
+}
+
+static void run_workers(const char *bench, int input, int size, int n, void *(*fn)(void *)) {
+	pthread_t tids[n];
+	worker ws[n];
+	uint64_t start = now_ns();
+	for (int k = 0; k < n; k++) {
+		memset(&ws[k], 0, sizeof(worker));
+		ws[k].input = input;
+		ws[k].size = size;
+		ws[k].deadline = start + (uint64_t)(seconds * 1e9);
+		pthread_create(&tids[k], NULL, fn, &ws[k]);
+	}
+	samples lat = {0};
+	uint64_t ops = 0, lost = 0;
+	for (int k = 0; k < n; k++) {
+		pthread_join(tids[k], NULL);
+		ops += ws[k].ops;
+		lost += ws[k].lost;
+		samples_merge(&lat, &ws[k].lat);
+	}
+	report(bench, size, n, ops, lost, now_ns() - start, &lat);
+}
+
+static void bench_trigger(int input, int size, int n) {
+	input_listen_start(input, "Trigger");
+	transit = 0;
+	transit_max = TRANSIT_BYTES / size;
+	if (transit_max < 2 * n) {
+		transit_max = 2 * n;
+	}
+	pthread_t tids[n];
+	worker ws[n];
+	uint64_t start = now_ns();
+	for (int k = 0; k < n; k++) {
+		memset(&ws[k], 0, sizeof(worker));
+		ws[k].input = input;
+		ws[k].size = size;
+		ws[k].deadline = start + (uint64_t)(seconds * 1e9);
+		pthread_create(&tids[k], NULL, trigger_worker, &ws[k]);
+	}
+	samples lat = {0};
+	uint64_t received = 0, sent = 0, last = now_ns();
+	int senders = n;
+	while (senders > 0 || (received < sent && now_ns() - last < WAIT_MS * 1000000ULL)) {
+		if (senders > 0 && now_ns() > ws[0].deadline) {
+			for (int k = 0; k < n; k++) {
+				pthread_mutex_lock(&transit_m);
+				transit_max = transit + n + 1;
+				pthread_cond_broadcast(&transit_c);
+				pthread_mutex_unlock(&transit_m);
+				pthread_join(tids[k], NULL);
+				sent += ws[k].ops;
+			}
+			senders = 0;
+		}
+		int is;
+		input_listen_result_wait(input, 100, &is);
+		char *id, *function;
+		void *request_params, *params;
+		int request_params_size, params_size;
+		while (input_listen_result_take(input, &id, &function, &request_params, &request_params_size, &params, &params_size) == 0) {
+			if (params_size >= (int)sizeof(uint64_t)) {
+				samples_add(&lat, since_stamp(params));
+			}
+			received++;
+			last = now_ns();
+			free(id);
+			transit_done();
+		}
+	}
+	report("trigger", size, n, received, sent > received ? sent - received : 0, last - start, &lat);
+	input_listen_stop(input, "Trigger");
+}
+
+/* emit and observe ask the output to publish a burst and measure how it
+ * arrives. */
+static int64_t burst_count(int size) {
+	int64_t count = TRANSIT_BYTES / size;
+	return count < 16 ? 16 : count > 100000 ? 100000 : count;
+}
+
+static int start_burst(int input, char *function, int64_t count, int size) {
+	int64_t params[2] = {count, size};
+	char *id;
+	int id_size, ready = 0, done_size;
+	char done;
+	if (input_call(input, function, params, sizeof(params), &id, &id_size) != 0) {
+		return -1;
+	}
+	input_call_result_wait(input, id, WAIT_MS, &ready);
+	input_call_result_params_into(input, id, &done, 1, &done_size);
+	free(id);
+	return ready ? 0 : -1;
+}
+
+static void bench_emit(int input, int size) {
+	input_listen_start(input, "Tick");
+	int64_t count = burst_count(size);
+	samples lat = {0};
+	uint64_t received = 0, start = now_ns(), last = start;
+	if (start_burst(input, "Publish", count, size) == 0) {
+		while (received < (uint64_t)count && now_ns() - last < WAIT_MS * 1000000ULL) {
+			int is;
+			input_listen_result_wait(input, 100, &is);
+			char *id, *function;
+			void *request_params, *params;
+			int request_params_size, params_size;
+			while (input_listen_result_take(input, &id, &function, &request_params, &request_params_size, &params, &params_size) == 0) {
+				if (params_size >= (int)sizeof(uint64_t)) {
+					samples_add(&lat, since_stamp(params));
+				}
+				received++;
+				last = now_ns();
+				free(id);
+			}
+		}
+	}
+	report("emit", size, 1, received, count - received, last - start, &lat);
+	input_listen_stop(input, "Tick");
+}
+
+static void bench_observe(int input, int size) {
+	input_change_start_observe(input, "Value");
+	int64_t count = burst_count(size);
+	samples lat = {0};
+	uint64_t received = 0, start = now_ns(), last = start;
+	if (start_burst(input, "Change", count, size) == 0) {
+		while (received < (uint64_t)count && now_ns() - last < WAIT_MS * 1000000ULL) {
+			int is;
+			input_change_wait(input, 100, &is);
+			char *property;
+			void *value;
+			int value_size;
+			while (input_change_take(input, &property, &value, &value_size) == 0) {
+				if (value_size >= (int)sizeof(uint64_t)) {
+					samples_add(&lat, since_stamp(value));
+				}
+				received++;
+				last = now_ns();
+				free(property);
+			}
+		}
+	}
+	report("observe", size, 1, received, count - received, last - start, &lat);
+	input_change_stop_observe(input, "Value");
+}
+
+static int enabled(const char *bench) {
+	size_t n = strlen(bench);
+	for (const char *p = benchmarks; (p = strstr(p, bench)) != NULL; p += n) {
+		if ((p == benchmarks || p[-1] == ',') && (p[n] == ',' || p[n] == 0)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int parse_list(char *arg, int *list) {
+	int n = 0;
+	for (char *tok = strtok(arg, ","); tok != NULL && n < MAX_LIST; tok = strtok(NULL, ",")) {
+		list[n++] = atoi(tok);
+	}
+	return n;
+}
+
+static pid_t spawn_server(char *self) {
+	pid_t pid = fork();
+	if (pid == 0) {
+		char *args[] = {self, "--serve", NULL};
+		execv("/proc/self/exe", args);
+		_exit(127);
+	}
+	return pid;
+}
+
+int main(int argc, char **argv) {
+	int local = 0;
+	for (int k = 1; k < argc; k++) {
+		if (strcmp(argv[k], "--serve") == 0) {
+			return run_server();
+		} else if (strcmp(argv[k], "--transport") == 0 && k + 1 < argc) {
+			local = strcmp(argv[++k], "local") == 0;
+		} else if (strcmp(argv[k], "--seconds") == 0 && k + 1 < argc) {
+			seconds = atof(argv[++k]);
+		} else if (strcmp(argv[k], "--sizes") == 0 && k + 1 < argc) {
+			n_sizes = parse_list(argv[++k], sizes);
+		} else if (strcmp(argv[k], "--threads") == 0 && k + 1 < argc) {
+			n_threads = parse_list(argv[++k], threads);
+		} else if (strcmp(argv[k], "--benchmarks") == 0 && k + 1 < argc) {
+			benchmarks = argv[++k];
+		} else {
+			fprintf(stderr, "unknown argument %s\n", argv[k]);
+			return 2;
+		}
+	}
+	if (local) {
+		transport = "local";
+	} else if (getenv("TVIO_SHM") != NULL && strcmp(getenv("TVIO_SHM"), "1") == 0) {
+		transport = "shm";
+	}
+
+	pid_t server = 0;
+	int output = -1;
+	if (local) {
+		output = start_output();
+		if (output < 0) {
+			fprintf(stderr, "failed to create output: %d\n", output);
+			return 1;
+		}
+	} else {
+		server = spawn_server(argv[0]);
+	}
+
+	int input = new_input(DESCRIPTOR);
+	if (input < 0) {
+		fprintf(stderr, "failed to create input: %d\n", input);
+		return 1;
+	}
+	int connected = 0;
+	for (int k = 0; k < 300 && !connected; k++) {
+		input_connected(input, &connected);
+		usleep(100000);
+	}
+	if (!connected) {
+		fprintf(stderr, "input did not connect\n");
+		return 1;
+	}
+
+	/* Warm up connections, the shared memory transport and the Go heap. */
+	double measured = seconds;
+	seconds = 1;
+	run_workers("warmup", input, 16, 1, call_worker);
+	seconds = measured;
+
+	for (int s = 0; s < n_sizes; s++) {
+		int size = sizes[s] < (int)sizeof(uint64_t) ? (int)sizeof(uint64_t) : sizes[s];
+		for (int t = 0; t < n_threads; t++) {
+			if (enabled("call")) {
+				fprintf(stderr, "call size %d threads %d\n", size, threads[t]);
+				run_workers("call", input, size, threads[t], call_worker);
+			}
+			if (enabled("callall")) {
+				fprintf(stderr, "callall size %d threads %d\n", size, threads[t]);
+				run_workers("callall", input, size, threads[t], call_all_worker);
+			}
+			if (enabled("trigger")) {
+				fprintf(stderr, "trigger size %d threads %d\n", size, threads[t]);
+				bench_trigger(input, size, threads[t]);
+			}
+		}
+		if (enabled("emit")) {
+			fprintf(stderr, "emit size %d\n", size);
+			bench_emit(input, size);
+		}
+		if (enabled("observe")) {
+			fprintf(stderr, "observe size %d\n", size);
+			bench_observe(input, size);
+		}
+	}
+
+	input_remove(input);
+	if (local) {
+		stop_output(output);
+	} else {
+		kill(server, SIGTERM);
+		waitpid(server, NULL, 0);
+	}
+	return 0;
+}
@@ -2,7 +2,7 @@ del /F /Q bin
 
 go get github.com/ThingiverseIO/thingiverseio
 
-go build -a --buildmode="c-archive" -o tvio.a src/input.go src/output.go src/error.go src/main.go
+go build -a --buildmode="c-archive" -o tvio.a src/input.go src/output.go src/error.go src/main.go src/queue.go src/signal.go src/callback.go src/handles.go src/local.go src/mirror.go src/poll.go src/stats.go src/names.go src/codec.go src/serve.go src/shm_other.go src/eventfd_other.go
 
 mv lib/tvio.h include/
 
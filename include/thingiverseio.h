@@ -37,6 +37,39 @@
  * 	- ERR_INVALID_FUNCTION		= -10
  * 	- ERR_INVALID_PROPERTY		= -11
  * 	- ERR_NO_UPDATE			= -12
+ * 	- ERR_NOT_SUPPORTED		= -13
+ * 	- ERR_BUFFER_TOO_SMALL		= -14
+ * 	- ERR_QUEUE_FULL		= -15
+ * 	- ERR_INVALID_QUEUE		= -16
+ * 	- ERR_INVALID_CODEC		= -17
+ * 	- ERR_MALFORMED_PARAMETERS	= -18
+ */
+
+/**
+ * The error codes as constants.
+ */
+#define TVIO_NO_ERR			0
+#define TVIO_ERR_NETWORK		(-1)
+#define TVIO_ERR_INVALID_DESCRIPTOR	(-2)
+#define TVIO_ERR_INVALID_INPUT		(-3)
+#define TVIO_ERR_INVALID_OUTPUT		(-4)
+#define TVIO_ERR_INVALID_RESULT_ID	(-5)
+#define TVIO_ERR_INVALID_REQUEST_ID	(-6)
+#define TVIO_ERR_NO_RESULT_AVAILABLE	(-7)
+#define TVIO_ERR_NO_REQUEST_AVAILABLE	(-8)
+#define TVIO_ERR_RESULT_NOT_ARRIVED	(-9)
+#define TVIO_ERR_INVALID_FUNCTION	(-10)
+#define TVIO_ERR_INVALID_PROPERTY	(-11)
+#define TVIO_ERR_NO_UPDATE		(-12)
+#define TVIO_ERR_NOT_SUPPORTED		(-13)
+#define TVIO_ERR_BUFFER_TOO_SMALL	(-14)
+#define TVIO_ERR_QUEUE_FULL		(-15)
+#define TVIO_ERR_INVALID_QUEUE		(-16)
+#define TVIO_ERR_INVALID_CODEC		(-17)
+#define TVIO_ERR_MALFORMED_PARAMETERS	(-18)
+
+/**
+ * Caller supplied buffers: the *_into functions and tvio_codec_pack write into a buffer of the given capacity, a negative capacity counts as 0. If the data does not fit, nothing is written, the size is set to the required size and ERR_BUFFER_TOO_SMALL is returned, so the call can be retried with a larger buffer.
  */
 
 
@@ -44,6 +77,149 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Callback which receives the requests of an output, see tvio_output_set_request_handler.
+ *
+ * @param output The output reference.
+ * @param id The UUID of the request.
+ * @param function The function name of the request.
+ * @param params The MsgPack serialized parameters of the request.
+ * @param params_size The size of the serialized parameters.
+ * @param userdata The userdata given when the handler was set.
+ */
+typedef void (*tvio_request_handler)(int output, char* id, char* function, void* params, int params_size, void* userdata);
+
+/**
+ * @brief Callback which serves a request on a worker of tvio_output_serve.
+ *
+ * @param output The output reference.
+ * @param worker The index of the worker, from 0 to the number of workers - 1. Handlers can keep per worker state with it.
+ * @param function The id of the requested function, see tvio_output_function_id.
+ * @param params The MsgPack serialized parameters of the request, only valid until the handler returns.
+ * @param params_size The size of the serialized parameters.
+ * @param reply A pointer which is NULL on entry. Set it to a buffer allocated with malloc holding the serialized reply, the library frees it. Leaving it NULL sends an empty reply.
+ * @param reply_size A pointer which has to be set to the size of the reply.
+ * @param userdata The userdata given to tvio_output_serve.
+ */
+typedef void (*tvio_serve_handler)(int output, int worker, int function, void* params, int params_size, void** reply, int* reply_size, void* userdata);
+
+/**
+ * @brief Callback which hands a buffer passed to one of the *_nocopy functions back to the caller.
+ *
+ * @param data The buffer which is no longer used by the library.
+ * @param userdata The userdata given with the buffer.
+ */
+typedef void (*tvio_release_handler)(void* data, void* userdata);
+
+/**
+ * Handle kinds and ready flags of tvio_poll.
+ */
+#define TVIO_POLL_INPUT		0
+#define TVIO_POLL_OUTPUT	1
+
+#define TVIO_POLL_REQUEST	1	/**< The output has pending requests. */
+#define TVIO_POLL_RESULT	2	/**< The input has CALL or CALL-ALL results. */
+#define TVIO_POLL_LISTEN	4	/**< The input has listen results. */
+#define TVIO_POLL_CHANGE	8	/**< The input has property changes. */
+#define TVIO_POLL_INVALID	16	/**< The handle does not exist or was removed. */
+
+#define TVIO_HISTOGRAM_BUCKETS	288
+
+/**
+ * @brief A log-linear latency histogram in nanoseconds. Values below 8ns get a bucket each. Above that, every power of two is split into 8 linear sub-buckets, see tvio_histogram_bucket_min. Values beyond the last bucket are counted in it.
+ */
+typedef struct {
+	unsigned long long count;	/**< Number of recorded values. */
+	unsigned long long sum_ns;	/**< Sum of all recorded values. */
+	unsigned long long buckets[TVIO_HISTOGRAM_BUCKETS];
+} tvio_histogram;
+
+/**
+ * @brief Returns the smallest value in nanoseconds counted in bucket k of a tvio_histogram.
+ */
+static inline unsigned long long tvio_histogram_bucket_min(int k) {
+	if (k < 8) {
+		return k;
+	}
+	int e = (k - 8) / 8 + 3;
+	return (8ULL + (k - 8) % 8) << (e - 3);
+}
+
+/**
+ * @brief Statistics of an input, see tvio_input_stats.
+ */
+typedef struct {
+	unsigned long long requests_sent;	/**< CALL, CALL-ALL and TRIGGER requests sent. */
+	unsigned long long results_received;	/**< CALL, CALL-ALL and listen results received. */
+	unsigned long long bytes_out;		/**< Size of the parameters sent. */
+	unsigned long long bytes_in;		/**< Size of the results received. */
+	unsigned long long results_depth;	/**< Pending CALL results. */
+	unsigned long long callall_depth;	/**< Open CALL-ALL requests. */
+	unsigned long long listen_depth;	/**< Queued listen results. */
+	unsigned long long changes_depth;	/**< Queued property changes. */
+	tvio_histogram call_time;		/**< Round trip time of CALLs. */
+} tvio_input_statistics;
+
+/**
+ * @brief Statistics of an output, see tvio_output_stats.
+ */
+typedef struct {
+	unsigned long long requests_received;	/**< Requests received. */
+	unsigned long long results_sent;	/**< Replies and emitted results. */
+	unsigned long long bytes_in;		/**< Size of the request parameters received. */
+	unsigned long long bytes_out;		/**< Size of the results sent. */
+	unsigned long long requests_depth;	/**< Queued requests. */
+	unsigned long long request_cache_depth;	/**< Retrieved requests which were not answered yet. */
+	tvio_histogram queue_time;		/**< Time requests waited until the host retrieved them. */
+} tvio_output_statistics;
+
+/**
+ * @brief The mirror of a property, see tvio_input_property_mirror. Read it with tvio_property_mirror_read only. data is allocated with capacity bytes, which may exceed the struct.
+ */
+typedef struct {
+	unsigned int seq;	/**< Sequence counter, odd while the value is written. */
+	int size;		/**< Size of the value, larger than capacity if it did not fit. */
+	int capacity;		/**< Capacity of data. */
+	char data[1];		/**< The MsgPack serialized value. */
+} tvio_property_mirror;
+
+/**
+ * Overflow policies of bounded queues, see tvio_input_queue_set and tvio_output_queue_set.
+ */
+#define TVIO_QUEUE_BLOCK	0	/**< The producer waits until there is space. */
+#define TVIO_QUEUE_DROP_OLDEST	1	/**< The oldest item is dropped, a dropped in process CALL fails with ERR_QUEUE_FULL when its result is retrieved. */
+#define TVIO_QUEUE_DROP_NEWEST	2	/**< The new item is dropped, in process CALLs fail with ERR_QUEUE_FULL. */
+#define TVIO_QUEUE_REJECT	3	/**< The new item is rejected, in process CALLs fail with ERR_QUEUE_FULL. */
+
+/**
+ * Queues of an input, see tvio_input_queue_set.
+ */
+#define TVIO_QUEUE_LISTEN	0
+#define TVIO_QUEUE_CHANGE	1
+
+/**
+ * @brief A handle to wait on with tvio_poll.
+ */
+typedef struct {
+	int handle;	/**< The input or output reference. */
+	int kind;	/**< TVIO_POLL_INPUT or TVIO_POLL_OUTPUT. */
+	int ready;	/**< Set by tvio_poll to the TVIO_POLL_* flags of the handle. */
+} tvio_poll_item;
+
+/**
+ * Parameter lists of a function a codec can be compiled for, see tvio_codec_new.
+ */
+#define TVIO_CODEC_INPUT	0
+#define TVIO_CODEC_OUTPUT	1
+
+/**
+ * @brief A string or bin parameter in a struct packed or unpacked by a codec. Unpacked data points into the unpacked buffer and is not zero terminated.
+ */
+typedef struct {
+	void* data;
+	int size;
+} tvio_codec_bytes;
+
 	/**
 	 * @brief Gets the version of ThingiverseIO. Useful to check if the shared library is linked correctly.
 	 *
@@ -54,6 +230,18 @@ extern "C" {
 	 */
 extern void tvio_version(int* major, int* minor, int* fix);
 
+/**
+ * @brief Waits on many inputs and outputs at once. Returns as soon as at least one handle has pending data, or the timeout expires.
+ *
+ * @param items The handles to wait on, the ready field of each item is set on return.
+ * @param n The number of items.
+ * @param timeout_ms Maximum time to wait in milliseconds. 0 returns immediately, a negative value waits indefinitely.
+ * @param n_ready A pointer which will be set to the number of items with a ready field other than 0.
+ *
+ * @return error
+ */
+extern int tvio_poll(tvio_poll_item* items, int n, int timeout_ms, int* n_ready);
+
 /**
  * @brief Checks the given descriptor for semantic errors. The result be a human readable string describing the semantic errors. If the result pointer is empty after check, the descriptor is OK.
  *
@@ -74,6 +262,53 @@ extern void tvio_check_descriptor(char* descriptor, char** result, int* result_s
  */
 extern void tvio_error_message(int error, char** msg_p, int* msg_size);
 
+/**
+ * @brief Compiles a codec for the parameters of a function, which packs and unpacks their MsgPack map directly from and into a struct of the caller. No intermediate objects are allocated. Parameters are stored according to their type: int types as int64_t, float types as double, bool as bool and string and bin as tvio_codec_bytes. Other types are not supported.
+ *
+ * @param descriptor The descriptor declaring the function.
+ * @param function Name of the function.
+ * @param list TVIO_CODEC_INPUT for the input parameters, TVIO_CODEC_OUTPUT for the output parameters.
+ * @param offsets The offset of each parameter in the struct, in the order they are declared, e.g. offsetof(struct answer, Answer).
+ * @param n The number of offsets, which must match the number of parameters.
+ *
+ * @return A reference to the codec, or an error. ERR_INVALID_CODEC if list, n or the parameter types do not fit.
+ */
+extern int tvio_codec_new(char* descriptor, char* function, int list, int* offsets, int n);
+
+/**
+ * @brief Removes a codec.
+ *
+ * @param codec The codec reference.
+ *
+ * @return error
+ */
+extern int tvio_codec_remove(int codec);
+
+/**
+ * @brief Packs the struct at src into a caller supplied buffer, which can be reused across calls.
+ *
+ * @param codec The codec reference.
+ * @param src The struct to pack.
+ * @param buf The buffer to pack into.
+ * @param capacity The capacity of the buffer.
+ * @param size Pointer which will be set to the size of the packed parameters.
+ *
+ * @return error. ERR_MALFORMED_PARAMETERS if a string or bin field has a negative size, or no data but a positive size.
+ */
+extern int tvio_codec_pack(int codec, void* src, void* buf, int capacity, int* size);
+
+/**
+ * @brief Unpacks MsgPack serialized parameters into the struct at dst. Parameters are matched by name, unknown ones are skipped and fields of missing ones are left unchanged. String and bin fields point into data, which must outlive their use.
+ *
+ * @param codec The codec reference.
+ * @param data The serialized parameters.
+ * @param size The size of the serialized parameters.
+ * @param dst The struct to unpack into.
+ *
+ * @return error, ERR_MALFORMED_PARAMETERS if the data is no map or a value does not match the type of its parameter.
+ */
+extern int tvio_codec_unpack(int codec, void* data, int size, void* dst);
+
 /**
  * @brief Creates a new thingiverseio input.
  *
@@ -124,9 +359,44 @@ extern int tvio_input_uuid(int input, char** uuid_p, int* uuid_size);
  */
 extern int tvio_input_interface(int input, char** iface_p, int* iface_size);
 
+/**
+ * @brief Gets a file descriptor which becomes readable whenever new data arrives on an input, i.e. a call result, a CALL-ALL result, a listen result or a property change. The descriptor is an eventfd and only available on Linux. Read it to reset it, then drain the input until the *_available functions report nothing. If data is already pending when the descriptor is first requested, it is readable right away. The descriptor is owned by the input and closed when the input is removed.
+ *
+ * @param input The input reference.
+ * @param fd A pointer which will be set to the file descriptor.
+ *
+ * @return error
+ */
+extern int tvio_input_fd(int input, int* fd);
+
+/**
+ * @brief Resolves the name of a function to its id. Ids number the functions in the order they are declared in the descriptor and stay valid for the lifetime of the input. Passing the id to the *_id variants avoids converting and looking up the name on every call.
+ *
+ * @param input The input reference.
+ * @param function Name of the function.
+ * @param id A pointer which will be set to the id of the function.
+ *
+ * @return error, ERR_INVALID_FUNCTION if the descriptor does not declare the function.
+ */
+extern int tvio_input_function_id(int input, char* function, int* id);
+
+/**
+ * @brief Resolves the name of a property to its id, see tvio_input_function_id.
+ *
+ * @param input The input reference.
+ * @param property Name of the property.
+ * @param id A pointer which will be set to the id of the property.
+ *
+ * @return error, ERR_INVALID_PROPERTY if the descriptor does not declare the property.
+ */
+extern int tvio_input_property_id(int input, char* property, int* id);
+
 /**
  * @brief Executes a ThingiverseIO CALL.
  *
+ * If an output with the same interface exists in this process, the request is
+ * delivered to it directly without going through the network.
+ *
  * @param input
  * @param function Name of the function.
  * @param fparams A pointer to the MsgPack serialized parameters.
@@ -139,298 +409,774 @@ extern int tvio_input_interface(int input, char** iface_p, int* iface_size);
 extern int tvio_input_call(int input, char* function, void* fparams, int fparams_size, char** id, int* id_size);
 
 /**
- * @brief Executes a ThingiverseIO CALL-ALL.
+ * @brief Executes a ThingiverseIO CALL and writes the binary request UUID into caller owned storage. Binary UUIDs are the 16 bytes encoded by the hex digits of the UUID string and avoid allocating a string per call. All *_bin functions accept them in place of the UUID string.
  *
  * @param input The input reference.
  * @param function Name of the function.
  * @param fparams A pointer to the MsgPack serialized parameters.
  * @param fparams_size Size of the serialized parameters.
- * @param id A pointer which will be set to requests UUID.
- * @param id_size Size of the requests UUID.
+ * @param id A buffer of 16 bytes which will be set to the binary request UUID.
  *
  * @return error
  */
-extern int tvio_input_call_all(int input, char* function, void* fparams, int fparams_size, char** id, int* id_size);
+extern int tvio_input_call_bin(int input, char* function, void* fparams, int fparams_size, void* id);
 
 /**
- * @brief Executes a ThingiverseIO TRIGGER.
+ * @brief Executes a ThingiverseIO CALL of a function given by id, see tvio_input_function_id.
  *
  * @param input The input reference.
- * @param function Name of the function.
+ * @param function The id of the function.
  * @param fparams A pointer to the MsgPack serialized parameters.
  * @param fparams_size Size of the serialized parameters.
+ * @param id A pointer which will be set to requests UUID.
+ * @param id_size Size of the requests UUID.
  *
  * @return error
  */
-extern int tvio_input_trigger(int input, char* function, void* fparams, int fparams_size);
+extern int tvio_input_call_id(int input, int function, void* fparams, int fparams_size, char** id, int* id_size);
 
 /**
- * @brief Executes a ThingiverseIO TRIGGER-ALL.
+ * @brief Executes a ThingiverseIO CALL of a function given by id and writes the binary request UUID into caller owned storage, see tvio_input_call_bin.
  *
  * @param input The input reference.
- * @param function Name of the function.
+ * @param function The id of the function.
  * @param fparams A pointer to the MsgPack serialized parameters.
  * @param fparams_size Size of the serialized parameters.
+ * @param id A buffer of 16 bytes which will be set to the binary request UUID.
  *
  * @return error
  */
-extern int tvio_input_trigger_all(int input, char* function, void* fparams, int fparams_size);
+extern int tvio_input_call_id_bin(int input, int function, void* fparams, int fparams_size, void* id);
 
 /**
- * @brief Checks if the result for an request has arrived.
+ * @brief Executes a ThingiverseIO CALL-ALL.
  *
  * @param input The input reference.
- * @param id The UUID of the request.
- * @param ready A pointer which will be set to 1 if the result is ready, 0 otherwise.
+ * @param function Name of the function.
+ * @param fparams A pointer to the MsgPack serialized parameters.
+ * @param fparams_size Size of the serialized parameters.
+ * @param id A pointer which will be set to requests UUID.
+ * @param id_size Size of the requests UUID.
  *
  * @return error
  */
-extern int tvio_input_call_result_available(int input, char* id, int* ready);
+extern int tvio_input_call_all(int input, char* function, void* fparams, int fparams_size, char** id, int* id_size);
 
 /**
- * @brief Retrieves the MsgPack serialized parameters of a result.
+ * @brief Executes a ThingiverseIO CALL-ALL and writes the binary request UUID into caller owned storage.
  *
  * @param input The input reference.
- * @param id The UUID of the request.
- * @param params A pointer which will be set to serialized parameters.
- * @param params_size The size of the serialized parameters.
+ * @param function Name of the function.
+ * @param fparams A pointer to the MsgPack serialized parameters.
+ * @param fparams_size Size of the serialized parameters.
+ * @param id A buffer of 16 bytes which will be set to the binary request UUID.
  *
  * @return error
  */
-extern int tvio_input_call_result_params(int input, char* id, void** params, int* params_size);
+extern int tvio_input_call_all_bin(int input, char* function, void* fparams, int fparams_size, void* id);
 
 /**
- * @brief Makes the an input listen to the given function.
+ * @brief Executes a ThingiverseIO TRIGGER.
  *
  * @param input The input reference.
- * @param function Name of the function to listen.
+ * @param function Name of the function.
+ * @param fparams A pointer to the MsgPack serialized parameters.
+ * @param fparams_size Size of the serialized parameters.
  *
  * @return error
  */
-extern int tvio_input_listen_start(int input, char* function);
+extern int tvio_input_trigger(int input, char* function, void* fparams, int fparams_size);
 
 /**
- * @brief Makes an input stop listening to the given function.
+ * @brief Executes a ThingiverseIO TRIGGER of a function given by id, see tvio_input_function_id.
  *
  * @param input The input reference.
- * @param function Name of the function to stop listening.
+ * @param function The id of the function.
+ * @param fparams A pointer to the MsgPack serialized parameters.
+ * @param fparams_size Size of the serialized parameters.
  *
  * @return error
  */
-extern int tvio_input_listen_stop(int input, char* function);
+extern int tvio_input_trigger_id(int input, int function, void* fparams, int fparams_size);
 
 /**
- * @brief Checks if a new result from function which an input listening to is available.
+ * @brief Executes a ThingiverseIO TRIGGER-ALL.
  *
  * @param input The input reference.
- * @param is A pointer which will be set to 1 if a result is available, 0 otherwise.
+ * @param function Name of the function.
+ * @param fparams A pointer to the MsgPack serialized parameters.
+ * @param fparams_size Size of the serialized parameters.
  *
  * @return error
  */
-extern int tvio_input_listen_result_available(int input, int* is);
+extern int tvio_input_trigger_all(int input, char* function, void* fparams, int fparams_size);
 
 /**
- * @brief Retrieves UUID of the next available listen result.
+ * @brief Executes n ThingiverseIO CALLs in one call. The parameters are packed into one buffer, the parameters of call k start at offsets[k] and end at offsets[k+1]. The CALLs are issued in order, the first failing one stops the batch.
  *
  * @param input The input reference.
- * @param id A pointer which will be set to the results UUID.
- * @param id_size An int pointer which will be set to the size of the results UUID.
- *
- * @return error
+ * @param n The number of calls.
+ * @param functions An array of n function names.
+ * @param params A pointer to the packed MsgPack serialized parameters.
+ * @param offsets An array of n+1 parameter offsets, starting at 0 and never decreasing.
+ * @param ids A buffer of n*16 bytes which will be filled with the binary UUIDs of the requests. The UUIDs of calls which were not issued are all zeros.
+ * @param issued A pointer which will be set to the number of issued calls, so on error the call at this index failed. May be NULL.
+ *
+ * @return error, the error of the failed call, ERR_MALFORMED_PARAMETERS if n or the offsets are invalid.
  */
-extern int tvio_input_listen_result_id(int input, char** id, int* id_size);
+extern int tvio_input_call_batch(int input, int n, char** functions, void* params, int* offsets, void* ids, int* issued);
 
 /**
- * @brief Retrieves the function name the next available listen result.
+ * @brief Executes n ThingiverseIO TRIGGERs in one call. The parameters are packed into one buffer, the parameters of trigger k start at offsets[k] and end at offsets[k+1]. The TRIGGERs are issued in order, the first failing one stops the batch.
  *
  * @param input The input reference.
- * @param function A pointer which will be set to the results function name.
- * @param function_size A pointer which will be set to the size of the results function name.
+ * @param n The number of triggers.
+ * @param functions An array of n function names.
+ * @param params A pointer to the packed MsgPack serialized parameters.
+ * @param offsets An array of n+1 parameter offsets, starting at 0 and never decreasing.
+ * @param issued A pointer which will be set to the number of issued triggers, so on error the trigger at this index failed. May be NULL.
  *
- * @return error
+ * @return error, ERR_INVALID_FUNCTION if a trigger failed, ERR_MALFORMED_PARAMETERS if n or the offsets are invalid.
  */
-extern int tvio_input_listen_result_function(int input, char** function, int* function_size);
+extern int tvio_input_trigger_batch(int input, int n, char** functions, void* params, int* offsets, int* issued);
 
 /**
- * @brief Retrieves the MsgPack serialized request parameters of the next available listen result.
+ * @brief Checks if the result for an request has arrived.
  *
  * @param input The input reference.
- * @param params A pointer which will be set to the parameters of the listen result.
- * @param params_size A pointer which will be set to size of the result parameters.
+ * @param id The UUID of the request.
+ * @param ready A pointer which will be set to 1 if the result is ready, 0 otherwise.
  *
  * @return error
  */
-extern int tvio_input_listen_result_request_params(int input, void** params, int* params_size);
+extern int tvio_input_call_result_available(int input, char* id, int* ready);
 
 /**
- * @brief Retrieves the MsgPack serialized parameters of the next available listen result.
+ * @brief Checks if the result for an request has arrived. The UUID is given in its 16 byte binary form, see tvio_input_call_bin.
  *
  * @param input The input reference.
- * @param params A pointer which will be set to the parameters of the listen result.
- * @param params_size A pointer which will be set to size of the result parameters.
+ * @param id The 16 byte binary UUID of the request.
+ * @param ready A pointer which will be set to 1 if the result is ready, 0 otherwise.
  *
  * @return error
  */
-extern int tvio_input_listen_result_params(int input, void** params, int* params_size);
+extern int tvio_input_call_result_available_bin(int input, void* id, int* ready);
 
 /**
- * @brief Clears the next listen result. Must be called to receive following results.
+ * @brief Blocks until the result for an request has arrived or the timeout expires.
  *
  * @param input The input reference.
+ * @param id The UUID of the request.
+ * @param timeout_ms Maximum time to wait in milliseconds. 0 returns immediately, a negative value waits indefinitely.
+ * @param ready A pointer which will be set to 1 if the result is ready, 0 otherwise.
  *
  * @return error
  */
-extern int tvio_input_listen_result_clear(int input);
+extern int tvio_input_call_result_wait(int input, char* id, int timeout_ms, int* ready);
 
 /**
- * @brief Checks if a CALL-ALL result is available.
+ * @brief Blocks until the result for an request has arrived or the timeout expires. The UUID is given in its 16 byte binary form, see tvio_input_call_bin.
  *
  * @param input The input reference.
- * @param id The UUID of the request.
- * @param is A pointer which will be set to 1 if a result is available, 0 otherwise.
+ * @param id The 16 byte binary UUID of the request.
+ * @param timeout_ms Maximum time to wait in milliseconds. 0 returns immediately, a negative value waits indefinitely.
+ * @param ready A pointer which will be set to 1 if the result is ready, 0 otherwise.
  *
  * @return error
  */
-extern int tvio_input_call_all_next_result_available(int input, int* is);
+extern int tvio_input_call_result_wait_bin(int input, void* id, int timeout_ms, int* ready);
 
 /**
- * @brief Retrieves the next available parameters of a CALL-ALL result.
+ * @brief Retrieves the MsgPack serialized parameters of a result.
  *
  * @param input The input reference.
  * @param id The UUID of the request.
- * @param params A pointer which will be set to the parameters of the listen result.
- * @param params_size A pointer which will be set to size of the result parameters.
+ * @param params A pointer which will be set to serialized parameters.
+ * @param params_size The size of the serialized parameters.
  *
  * @return error
  */
-extern int tvio_input_call_all_next_result_params(int input, char* id, void** params, int* params_size);
+extern int tvio_input_call_result_params(int input, char* id, void** params, int* params_size);
 
 /**
- * @brief Clears the next CALL-ALL result. Must be called to receive further results.
+ * @brief Retrieves the MsgPack serialized parameters of a result into a caller supplied buffer. The result is only cleared if it fits into the buffer.
  *
  * @param input The input reference.
  * @param id The UUID of the request.
+ * @param buf The buffer to copy into.
+ * @param capacity The capacity of the buffer.
+ * @param params_size A pointer which will be set to the size of the serialized parameters.
  *
  * @return error
  */
-extern int tvio_input_call_all_next_result_clear(int input, char* id);
+extern int tvio_input_call_result_params_into(int input, char* id, void* buf, int capacity, int* params_size);
 
 /**
- * @brief Clears the CALL-ALL request.
+ * @brief Retrieves the MsgPack serialized parameters of a result. The UUID is given in its 16 byte binary form, see tvio_input_call_bin.
  *
  * @param input The input reference.
- * @param id The UUID of the request.
+ * @param id The 16 byte binary UUID of the request.
+ * @param params A pointer which will be set to serialized parameters.
+ * @param params_size The size of the serialized parameters.
  *
  * @return error
  */
-extern int tvio_input_call_all_request_clear(int input, char* id);
+extern int tvio_input_call_result_params_bin(int input, void* id, void** params, int* params_size);
 
 /**
- * @brief Gets the MsgPack serialized value of a property.
+ * @brief Enables the completion queue of an input. Every CALL result which arrives afterwards is queued until it is retrieved with tvio_input_completions_take.
  *
  * @param input The input reference.
- * @param property The name of the property.
- * @param value Pointer which will be set to the serialized value.
- * @param value_size Pointer which will be set to the size of the serialized data.
  *
  * @return error
  */
-extern int tvio_input_property_get(int input, char* property, void** value, int* value_size);
+extern int tvio_input_completions_start(int input);
 
 /**
- * @brief Initiates an update of a property.
+ * @brief Blocks until the completion queue is not empty or the timeout expires.
  *
  * @param input The input reference.
- * @param property The name of the property.
+ * @param timeout_ms Maximum time to wait in milliseconds. 0 returns immediately, a negative value waits indefinitely.
+ * @param is A pointer which will be set to 1 if a completion is available, 0 otherwise.
  *
- * @return error
+ * @return error, ERR_NOT_SUPPORTED if the completion queue was not started.
  */
-extern int tvio_input_property_update(int input, char* property);
+extern int tvio_input_completions_wait(int input, int timeout_ms, int* is);
 
 /**
- * @brief Checks if an update for a property is available.
+ * @brief Retrieves up to max completed CALLs in one call. If params is not NULL, the results are retrieved and cleared as well: the parameters of all results are packed into one buffer, the parameters of result k start at offsets[k] and end at offsets[k+1], and params has to be freed if at least one result was retrieved. If params is NULL, the results stay available through the id based functions. CALLs whose result was already retrieved by id are skipped. A CALL which failed, e.g. because its output in the same process was removed, is listed with empty parameters and is not cleared, tvio_input_call_result_params_bin then returns its error.
  *
  * @param input The input reference.
- * @param property The name of the property.
- * @param is A pointer which will be set to 1 if an update is available, 0 otherwise.
+ * @param max The maximum number of completions to retrieve.
+ * @param ids A buffer of at least 16*max bytes which will be filled with the 16 byte binary UUIDs of the requests.
+ * @param offsets An array of at least max+1 entries which will be set to the parameter offsets, may be NULL if params is NULL.
+ * @param params A pointer which will be set to the packed MsgPack serialized parameters, or NULL.
+ * @param n A pointer which will be set to the number of retrieved completions.
  *
- * @return error
+ * @return error, ERR_RESULT_NOT_ARRIVED if no CALL has completed.
  */
-extern int tvio_input_property_update_available(int input, char* property, int* is);
+extern int tvio_input_completions_take(int input, int max, void* ids, int* offsets, void** params, int* n);
 
 /**
- * @brief Gets the MsgPack serialized value of a property update.
+ * @brief Bounds one of the queues of an input. By default all queues are unbounded.
  *
  * @param input The input reference.
- * @param property The name of the property.
- * @param value Pointer which will be set to the serialized value.
- * @param value_size Pointer which will be set to the size of the serialized data.
+ * @param queue TVIO_QUEUE_LISTEN or TVIO_QUEUE_CHANGE.
+ * @param capacity The maximum number of queued items, 0 removes the bound.
+ * @param policy One of the TVIO_QUEUE_* policies, applied when the queue is full.
  *
  * @return error
  */
-extern int tvio_input_property_update_get(int input, char* property, void** value, int* value_size);
+extern int tvio_input_queue_set(int input, int queue, int capacity, int policy);
 
 /**
- * @brief Makes the an input start observing changes to a property.
+ * @brief Retrieves the length and overflow counters of one of the queues of an input.
  *
  * @param input The input reference.
- * @param property The name of the property.
+ * @param queue TVIO_QUEUE_LISTEN or TVIO_QUEUE_CHANGE.
+ * @param length A pointer which will be set to the number of queued items.
+ * @param dropped A pointer which will be set to the number of dropped items.
+ * @param rejected A pointer which will be set to the number of rejected items.
  *
  * @return error
  */
-extern int tvio_input_change_start_observe(int input, char* property);
+extern int tvio_input_queue_stats(int input, int queue, int* length, unsigned long long* dropped, unsigned long long* rejected);
 
 /**
- * @brief Makes the an input stop observing changes to a property.
+ * @brief Retrieves the statistics of an input. The counters are updated atomically, reading them does not block the input.
  *
  * @param input The input reference.
- * @param property The name of the property.
+ * @param stats A pointer to the statistics to fill in.
  *
  * @return error
  */
-extern int tvio_input_change_stop_observe(int input, char* property);
+extern int tvio_input_stats(int input, tvio_input_statistics* stats);
 
 /**
- * @brief Checks if a property change is available.
+ * @brief Makes the an input listen to the given function.
  *
  * @param input The input reference.
- * @param is A pointer which will be set to 1 if an update is available, 0 otherwise.
+ * @param function Name of the function to listen.
  *
  * @return error
  */
-extern int tvio_input_change_available(int input, int* is);
+extern int tvio_input_listen_start(int input, char* function);
 
 /**
- * @brief Gets the the name of the changed property.
+ * @brief Makes an input stop listening to the given function.
  *
  * @param input The input reference.
- * @param property Pointer which will be set to the name of the property.
- * @param property_size Pointer which will be set to the size of the name of the property.
+ * @param function Name of the function to stop listening.
  *
  * @return error
  */
-extern int tvio_input_change_property(int input, char** property, int* property_size);
+extern int tvio_input_listen_stop(int input, char* function);
 
 /**
- * @brief Gets the MsgPack serialized value of the changed property.
+ * @brief Checks if a new result from function which an input listening to is available.
  *
  * @param input The input reference.
- * @param property The name of the property.
- * @param value Pointer which will be set to the serialized value.
- * @param value_size Pointer which will be set to the size of the serialized data.
+ * @param is A pointer which will be set to 1 if a result is available, 0 otherwise.
  *
  * @return error
  */
-extern int tvio_input_change_value(int input, void** value, int* value_size);
+extern int tvio_input_listen_result_available(int input, int* is);
 
 /**
- * @brief Clears the current property change. Must be called to receive further changes.
+ * @brief Blocks until a new listen result is available or the timeout expires.
  *
  * @param input The input reference.
+ * @param timeout_ms Maximum time to wait in milliseconds. 0 returns immediately, a negative value waits indefinitely.
+ * @param is A pointer which will be set to 1 if a result is available, 0 otherwise.
  *
  * @return error
  */
-extern int tvio_input_change_clear(int input);
+extern int tvio_input_listen_result_wait(int input, int timeout_ms, int* is);
+
+/**
+ * @brief Retrieves UUID of the next available listen result.
+ *
+ * @param input The input reference.
+ * @param id A pointer which will be set to the results UUID.
+ * @param id_size An int pointer which will be set to the size of the results UUID.
+ *
+ * @return error
+ */
+extern int tvio_input_listen_result_id(int input, char** id, int* id_size);
+
+/**
+ * @brief Retrieves the binary UUID of the next available listen result.
+ *
+ * @param input The input reference.
+ * @param id A buffer of 16 bytes which will be set to the binary UUID of the result.
+ *
+ * @return error
+ */
+extern int tvio_input_listen_result_id_bin(int input, void* id);
+
+/**
+ * @brief Retrieves the function name the next available listen result.
+ *
+ * @param input The input reference.
+ * @param function A pointer which will be set to the results function name.
+ * @param function_size A pointer which will be set to the size of the results function name.
+ *
+ * @return error
+ */
+extern int tvio_input_listen_result_function(int input, char** function, int* function_size);
+
+/**
+ * @brief Retrieves the MsgPack serialized request parameters of the next available listen result.
+ *
+ * @param input The input reference.
+ * @param params A pointer which will be set to the parameters of the listen result.
+ * @param params_size A pointer which will be set to size of the result parameters.
+ *
+ * @return error
+ */
+extern int tvio_input_listen_result_request_params(int input, void** params, int* params_size);
+
+/**
+ * @brief Retrieves the MsgPack serialized request parameters of the next available listen result into a caller supplied buffer.
+ *
+ * @param input The input reference.
+ * @param buf The buffer to copy into.
+ * @param capacity The capacity of the buffer.
+ * @param params_size A pointer which will be set to size of the request parameters.
+ *
+ * @return error
+ */
+extern int tvio_input_listen_result_request_params_into(int input, void* buf, int capacity, int* params_size);
+
+/**
+ * @brief Retrieves the MsgPack serialized parameters of the next available listen result.
+ *
+ * @param input The input reference.
+ * @param params A pointer which will be set to the parameters of the listen result.
+ * @param params_size A pointer which will be set to size of the result parameters.
+ *
+ * @return error
+ */
+extern int tvio_input_listen_result_params(int input, void** params, int* params_size);
+
+/**
+ * @brief Retrieves the MsgPack serialized parameters of the next available listen result into a caller supplied buffer.
+ *
+ * @param input The input reference.
+ * @param buf The buffer to copy into.
+ * @param capacity The capacity of the buffer.
+ * @param params_size A pointer which will be set to size of the result parameters.
+ *
+ * @return error
+ */
+extern int tvio_input_listen_result_params_into(int input, void* buf, int capacity, int* params_size);
+
+/**
+ * @brief Clears the next listen result. Must be called to receive following results.
+ *
+ * @param input The input reference.
+ *
+ * @return error
+ */
+extern int tvio_input_listen_result_clear(int input);
+
+/**
+ * @brief Retrieves and clears the next available listen result in one call. All returned pointers point into a single allocation, only id has to be freed.
+ *
+ * @param input The input reference.
+ * @param id A pointer which will be set to the results UUID.
+ * @param function A pointer which will be set to the results function name.
+ * @param request_params A pointer which will be set to the MsgPack serialized request parameters.
+ * @param request_params_size A pointer which will be set to the size of the request parameters.
+ * @param params A pointer which will be set to the MsgPack serialized result parameters.
+ * @param params_size A pointer which will be set to the size of the result parameters.
+ *
+ * @return error
+ */
+extern int tvio_input_listen_result_take(int input, char** id, char** function, void** request_params, int* request_params_size, void** params, int* params_size);
+
+/**
+ * @brief Checks if a CALL-ALL result is available.
+ *
+ * @param input The input reference.
+ * @param id The UUID of the request.
+ * @param is A pointer which will be set to 1 if a result is available, 0 otherwise.
+ *
+ * @return error
+ */
+extern int tvio_input_call_all_next_result_available(int input, int* is);
+
+/**
+ * @brief Checks if a CALL-ALL result is available. The UUID is given in its 16 byte binary form, see tvio_input_call_bin.
+ *
+ * @param input The input reference.
+ * @param id The 16 byte binary UUID of the request.
+ * @param is A pointer which will be set to 1 if a result is available, 0 otherwise.
+ *
+ * @return error
+ */
+extern int tvio_input_call_all_next_result_available_bin(int input, void* id, int* is);
+
+/**
+ * @brief Retrieves the next available parameters of a CALL-ALL result.
+ *
+ * @param input The input reference.
+ * @param id The UUID of the request.
+ * @param params A pointer which will be set to the parameters of the listen result.
+ * @param params_size A pointer which will be set to size of the result parameters.
+ *
+ * @return error
+ */
+extern int tvio_input_call_all_next_result_params(int input, char* id, void** params, int* params_size);
+
+/**
+ * @brief Retrieves the next available parameters of a CALL-ALL result into a caller supplied buffer.
+ *
+ * @param input The input reference.
+ * @param id The UUID of the request.
+ * @param buf The buffer to copy into.
+ * @param capacity The capacity of the buffer.
+ * @param params_size A pointer which will be set to size of the result parameters.
+ *
+ * @return error
+ */
+extern int tvio_input_call_all_next_result_params_into(int input, char* id, void* buf, int capacity, int* params_size);
+
+/**
+ * @brief Retrieves the next available parameters of a CALL-ALL result. The UUID is given in its 16 byte binary form, see tvio_input_call_bin.
+ *
+ * @param input The input reference.
+ * @param id The 16 byte binary UUID of the request.
+ * @param params A pointer which will be set to the parameters of the listen result.
+ * @param params_size A pointer which will be set to size of the result parameters.
+ *
+ * @return error
+ */
+extern int tvio_input_call_all_next_result_params_bin(int input, void* id, void** params, int* params_size);
+
+/**
+ * @brief Clears the next CALL-ALL result. Must be called to receive further results.
+ *
+ * @param input The input reference.
+ * @param id The UUID of the request.
+ *
+ * @return error
+ */
+extern int tvio_input_call_all_next_result_clear(int input, char* id);
+
+/**
+ * @brief Clears the next CALL-ALL result. The UUID is given in its 16 byte binary form, see tvio_input_call_bin.
+ *
+ * @param input The input reference.
+ * @param id The 16 byte binary UUID of the request.
+ *
+ * @return error
+ */
+extern int tvio_input_call_all_next_result_clear_bin(int input, void* id);
+
+/**
+ * @brief Clears the CALL-ALL request.
+ *
+ * @param input The input reference.
+ * @param id The UUID of the request.
+ *
+ * @return error
+ */
+extern int tvio_input_call_all_request_clear(int input, char* id);
+
+/**
+ * @brief Clears the CALL-ALL request. The UUID is given in its 16 byte binary form, see tvio_input_call_bin.
+ *
+ * @param input The input reference.
+ * @param id The 16 byte binary UUID of the request.
+ *
+ * @return error
+ */
+extern int tvio_input_call_all_request_clear_bin(int input, void* id);
+
+/**
+ * @brief Gets the MsgPack serialized value of a property.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ * @param value Pointer which will be set to the serialized value.
+ * @param value_size Pointer which will be set to the size of the serialized data.
+ *
+ * @return error
+ */
+extern int tvio_input_property_get(int input, char* property, void** value, int* value_size);
+
+/**
+ * @brief Gets the MsgPack serialized value of a property into a caller supplied buffer.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ * @param buf The buffer to copy into.
+ * @param capacity The capacity of the buffer.
+ * @param value_size Pointer which will be set to the size of the serialized data.
+ *
+ * @return error
+ */
+extern int tvio_input_property_get_into(int input, char* property, void* buf, int capacity, int* value_size);
+
+/**
+ * @brief Gets the MsgPack serialized value of a property given by id, see tvio_input_property_id.
+ *
+ * @param input The input reference.
+ * @param property The id of the property.
+ * @param value Pointer which will be set to the serialized data.
+ * @param value_size Pointer which will be set to the size of the serialized data.
+ *
+ * @return error
+ */
+extern int tvio_input_property_get_id(int input, int property, void** value, int* value_size);
+
+/**
+ * @brief Gets the MsgPack serialized value of a property given by id into a caller supplied buffer, see tvio_input_property_get_into.
+ *
+ * @param input The input reference.
+ * @param property The id of the property.
+ * @param buf The buffer to copy into.
+ * @param capacity The capacity of the buffer.
+ * @param value_size Pointer which will be set to the size of the serialized data.
+ *
+ * @return error
+ */
+extern int tvio_input_property_get_into_id(int input, int property, void* buf, int capacity, int* value_size);
+
+/**
+ * @brief Initiates an update of a property.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ *
+ * @return error
+ */
+extern int tvio_input_property_update(int input, char* property);
+
+/**
+ * @brief Checks if an update for a property is available.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ * @param is A pointer which will be set to 1 if an update is available, 0 otherwise.
+ *
+ * @return error
+ */
+extern int tvio_input_property_update_available(int input, char* property, int* is);
+
+/**
+ * @brief Gets the MsgPack serialized value of a property update.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ * @param value Pointer which will be set to the serialized value.
+ * @param value_size Pointer which will be set to the size of the serialized data.
+ *
+ * @return error
+ */
+extern int tvio_input_property_update_get(int input, char* property, void** value, int* value_size);
+
+/**
+ * @brief Gets the MsgPack serialized value of a property update into a caller supplied buffer. The update is only cleared if it fits into the buffer.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ * @param buf The buffer to copy into.
+ * @param capacity The capacity of the buffer.
+ * @param value_size Pointer which will be set to the size of the serialized data.
+ *
+ * @return error
+ */
+extern int tvio_input_property_update_get_into(int input, char* property, void* buf, int capacity, int* value_size);
+
+/**
+ * @brief Mirrors a property into memory which can be read with tvio_property_mirror_read without calling into the library. The mirror holds the current value and the property is observed from now on to keep it up to date, its changes are only queued if it is also observed with tvio_input_change_start_observe. Calling this again for the same property returns the existing mirror, or ERR_BUFFER_TOO_SMALL if it was created with a smaller capacity. The mirror is freed by tvio_input_remove.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ * @param capacity The maximum size of the mirrored value.
+ * @param mirror A pointer which will be set to the mirror.
+ *
+ * @return error, ERR_INVALID_PROPERTY if the property does not exist or cannot be observed.
+ */
+extern int tvio_input_property_mirror(int input, char* property, int capacity, tvio_property_mirror** mirror);
+
+/**
+ * @brief Copies the current value of a property mirror, retrying while the value is written.
+ *
+ * @param mirror The mirror.
+ * @param buf The buffer to copy the value into.
+ * @param capacity The size of buf.
+ * @param size A pointer which will be set to the size of the value.
+ *
+ * @return error, ERR_BUFFER_TOO_SMALL if the value does not fit into buf or the mirror.
+ */
+static inline int tvio_property_mirror_read(tvio_property_mirror* mirror, void* buf, int capacity, int* size) {
+	for (;;) {
+		unsigned int seq = __atomic_load_n(&mirror->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1) {
+			continue;
+		}
+		int n = __atomic_load_n(&mirror->size, __ATOMIC_RELAXED);
+		int fits = n <= mirror->capacity && n <= capacity;
+		if (fits) {
+			__builtin_memcpy(buf, mirror->data, n);
+		}
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&mirror->seq, __ATOMIC_RELAXED) == seq) {
+			*size = n;
+			return fits ? TVIO_NO_ERR : TVIO_ERR_BUFFER_TOO_SMALL;
+		}
+	}
+}
+
+/**
+ * @brief Makes the an input start observing changes to a property.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ *
+ * @return error
+ */
+extern int tvio_input_change_start_observe(int input, char* property);
+
+/**
+ * @brief Makes the an input start observing changes to a property, keeping only the newest value. While a change of the property is pending, further changes replace its value instead of being queued, so every read returns the latest state.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ *
+ * @return error
+ */
+extern int tvio_input_change_start_observe_coalesced(int input, char* property);
+
+/**
+ * @brief Makes the an input stop observing changes to a property. A mirrored property keeps updating its mirror, see tvio_input_property_mirror.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ *
+ * @return error
+ */
+extern int tvio_input_change_stop_observe(int input, char* property);
+
+/**
+ * @brief Checks if a property change is available.
+ *
+ * @param input The input reference.
+ * @param is A pointer which will be set to 1 if an update is available, 0 otherwise.
+ *
+ * @return error
+ */
+extern int tvio_input_change_available(int input, int* is);
+
+/**
+ * @brief Blocks until a property change is available or the timeout expires.
+ *
+ * @param input The input reference.
+ * @param timeout_ms Maximum time to wait in milliseconds. 0 returns immediately, a negative value waits indefinitely.
+ * @param is A pointer which will be set to 1 if a change is available, 0 otherwise.
+ *
+ * @return error
+ */
+extern int tvio_input_change_wait(int input, int timeout_ms, int* is);
+
+/**
+ * @brief Gets the the name of the changed property.
+ *
+ * @param input The input reference.
+ * @param property Pointer which will be set to the name of the property.
+ * @param property_size Pointer which will be set to the size of the name of the property.
+ *
+ * @return error
+ */
+extern int tvio_input_change_property(int input, char** property, int* property_size);
+
+/**
+ * @brief Gets the MsgPack serialized value of the changed property.
+ *
+ * @param input The input reference.
+ * @param property The name of the property.
+ * @param value Pointer which will be set to the serialized value.
+ * @param value_size Pointer which will be set to the size of the serialized data.
+ *
+ * @return error
+ */
+extern int tvio_input_change_value(int input, void** value, int* value_size);
+
+/**
+ * @brief Gets the MsgPack serialized value of the changed property into a caller supplied buffer.
+ *
+ * @param input The input reference.
+ * @param buf The buffer to copy into.
+ * @param capacity The capacity of the buffer.
+ * @param value_size Pointer which will be set to the size of the serialized data.
+ *
+ * @return error
+ */
+extern int tvio_input_change_value_into(int input, void* buf, int capacity, int* value_size);
+
+/**
+ * @brief Retrieves and clears the next property change in one call. Both returned pointers point into a single allocation, only property has to be freed.
+ *
+ * @param input The input reference.
+ * @param property Pointer which will be set to the name of the property.
+ * @param value Pointer which will be set to the serialized value.
+ * @param value_size Pointer which will be set to the size of the serialized data.
+ *
+ * @return error
+ */
+extern int tvio_input_change_take(int input, char** property, void** value, int* value_size);
+
+/**
+ * @brief Clears the current property change. Must be called to receive further changes.
+ *
+ * @param input The input reference.
+ *
+ * @return error
+ */
+extern int tvio_input_change_clear(int input);
 
 /**
  * @brief Creates a new thingiverseio output.
@@ -483,6 +1229,39 @@ extern int tvio_output_uuid(int output, char** uuid, int* uuid_size);
  */
 extern int tvio_output_interface(int output, char** iface_p, int* iface_size);
 
+/**
+ * @brief Gets a file descriptor which becomes readable whenever a new request arrives on an output. The descriptor is an eventfd and only available on Linux. Read it to reset it, then drain the output until tvio_output_request_available reports nothing. If data is already pending when the descriptor is first requested, it is readable right away. The descriptor is owned by the output and closed when the output is removed.
+ *
+ * @param output The output reference.
+ * @param fd A pointer which will be set to the file descriptor.
+ *
+ * @return error
+ */
+extern int tvio_output_fd(int output, int* fd);
+
+/**
+ * @brief Sets a handler which is called for every incoming request instead of queueing it. The handler runs on a library thread, one request at a time, so it should return quickly. It may reply immediately with tvio_output_reply or keep the UUID to reply later. All pointers passed to the handler are only valid until it returns. Requests queued before the handler was set remain available through tvio_output_request_id.
+ *
+ * @param output The output reference.
+ * @param handler The handler, NULL restores queueing.
+ * @param userdata A pointer which is passed to every handler call.
+ *
+ * @return error
+ */
+extern int tvio_output_set_request_handler(int output, tvio_request_handler handler, void* userdata);
+
+/**
+ * @brief Serves the requests of an output on a pool of worker threads. Each worker has its own request deque, incoming requests are spread across them and idle workers steal from busy ones. A handler replies by returning the reply, which is sent without taking any lock of the output, so throughput scales with the number of workers. The workers take precedence over a handler set with tvio_output_set_request_handler. Requests queued before remain available through tvio_output_request_id. Calling it again replaces the workers, the previous ones serve the requests already dispatched to them and stop.
+ *
+ * @param output The output reference.
+ * @param nthreads The number of workers, 0 starts one per CPU.
+ * @param handler The handler, NULL stops the workers and restores queueing.
+ * @param userdata A pointer which is passed to every handler call.
+ *
+ * @return error
+ */
+extern int tvio_output_serve(int output, int nthreads, tvio_serve_handler handler, void* userdata);
+
 /**
  * @brief Checks wether a new request is available.
  *
@@ -493,6 +1272,17 @@ extern int tvio_output_interface(int output, char** iface_p, int* iface_size);
  */
 extern int tvio_output_request_available(int output, int* is);
 
+/**
+ * @brief Blocks until a new request is available or the timeout expires.
+ *
+ * @param output The output reference.
+ * @param timeout_ms Maximum time to wait in milliseconds. 0 returns immediately, a negative value waits indefinitely.
+ * @param is A pointer which will be set to 1 if a request is available, 0 otherwise.
+ *
+ * @return error
+ */
+extern int tvio_output_request_wait(int output, int timeout_ms, int* is);
+
 /**
  * @brief Retrieves the UUID of the next available request.
  *
@@ -504,6 +1294,77 @@ extern int tvio_output_request_available(int output, int* is);
  */
 extern int tvio_output_request_id(int output, char** id, int* id_size);
 
+/**
+ * @brief Retrieves the binary UUID of the next available request.
+ *
+ * @param output The output reference.
+ * @param id A buffer of 16 bytes which will be set to the binary request UUID.
+ *
+ * @return error
+ */
+extern int tvio_output_request_id_bin(int output, void* id);
+
+/**
+ * @brief Retrieves the next available request with UUID, function name and parameters in one call. All returned pointers point into a single allocation, only id has to be freed.
+ *
+ * @param output The output reference.
+ * @param id A pointer which will be set to the requests UUID.
+ * @param function A pointer which will be set to the requests function name.
+ * @param params A pointer which will be set to the MsgPack serialized parameters of the request.
+ * @param params_size A pointer which will be set to size of the request parameters.
+ *
+ * @return error
+ */
+extern int tvio_output_request_take(int output, char** id, char** function, void** params, int* params_size);
+
+/**
+ * @brief Bounds the request queue of an output. By default it is unbounded. Requests which are dropped or rejected are never answered.
+ *
+ * @param output The output reference.
+ * @param capacity The maximum number of queued requests, 0 removes the bound.
+ * @param policy One of the TVIO_QUEUE_* policies, applied when the queue is full.
+ *
+ * @return error
+ */
+extern int tvio_output_queue_set(int output, int capacity, int policy);
+
+/**
+ * @brief Retrieves the length and overflow counters of the request queue of an output.
+ *
+ * @param output The output reference.
+ * @param length A pointer which will be set to the number of queued requests.
+ * @param dropped A pointer which will be set to the number of dropped requests.
+ * @param rejected A pointer which will be set to the number of rejected requests.
+ *
+ * @return error
+ */
+extern int tvio_output_queue_stats(int output, int* length, unsigned long long* dropped, unsigned long long* rejected);
+
+/**
+ * @brief Retrieves the statistics of an output. The counters are updated atomically, reading them does not block the output.
+ *
+ * @param output The output reference.
+ * @param stats A pointer to the statistics to fill in.
+ *
+ * @return error
+ */
+extern int tvio_output_stats(int output, tvio_output_statistics* stats);
+
+/**
+ * @brief Retrieves up to max available requests in one call. The parameters of all requests are packed into one buffer, the parameters of request k start at offsets[k] and end at offsets[k+1]. The UUIDs and function names point into the same allocation, only params has to be freed if at least one request was retrieved.
+ *
+ * @param output The output reference.
+ * @param max The maximum number of requests to retrieve.
+ * @param ids An array of at least max entries which will be set to the requests UUIDs.
+ * @param functions An array of at least max entries which will be set to the requests function names.
+ * @param offsets An array of at least max+1 entries which will be set to the parameter offsets.
+ * @param params A pointer which will be set to the packed MsgPack serialized parameters.
+ * @param n A pointer which will be set to the number of retrieved requests.
+ *
+ * @return error
+ */
+extern int tvio_output_request_take_batch(int output, int max, char** ids, char** functions, int* offsets, void** params, int* n);
+
 /**
  * @brief Retrieves the function name of a request.
  *
@@ -515,6 +1376,17 @@ extern int tvio_output_request_id(int output, char** id, int* id_size);
  */
 extern int tvio_output_request_function(int output, char* id, char** function, int* function_size);
 
+/**
+ * @brief Retrieves the function name of a request. The UUID is given in its 16 byte binary form, see tvio_input_call_bin.
+ *
+ * @param output The output reference.
+ * @param id The 16 byte binary request UUID.
+ * @param function A pointer which will be set to the results function name.
+ * @param function_size A pointer which will be set to the size of the results function name.
+ * @return error
+ */
+extern int tvio_output_request_function_bin(int output, void* id, char** function, int* function_size);
+
 /**
  * @brief Retrieves the MsgPack serialized parameters of a request.
  *
@@ -527,6 +1399,31 @@ extern int tvio_output_request_function(int output, char* id, char** function, i
  */
 extern int tvio_output_request_params(int output, char* id, void** params, int* params_size);
 
+/**
+ * @brief Retrieves the MsgPack serialized parameters of a request into a caller supplied buffer.
+ *
+ * @param output The output reference.
+ * @param id The request UUID.
+ * @param buf The buffer to copy into.
+ * @param capacity The capacity of the buffer.
+ * @param params_size A pointer which will be set to size of the request parameters.
+ *
+ * @return error
+ */
+extern int tvio_output_request_params_into(int output, char* id, void* buf, int capacity, int* params_size);
+
+/**
+ * @brief Retrieves the MsgPack serialized parameters of a request. The UUID is given in its 16 byte binary form, see tvio_input_call_bin.
+ *
+ * @param output The output reference.
+ * @param id The 16 byte binary request UUID.
+ * @param params A pointer which will be set to the parameters of the request.
+ * @param params_size A pointer which will be set to size of the request parameters.
+ *
+ * @return error
+ */
+extern int tvio_output_request_params_bin(int output, void* id, void** params, int* params_size);
+
 /**
  * @brief Replies to a request and sends the result to all concerned peers.
  *
@@ -539,6 +1436,67 @@ extern int tvio_output_request_params(int output, char* id, void** params, int*
  */
 extern int tvio_output_reply(int output, char* id, void* rparams, int rparams_size);
 
+/**
+ * @brief Replies to a request without copying the parameters. Over shared memory the reply is written directly from the given buffer, the other transports copy it once. Release is called exactly once, also on error, before this function returns.
+ *
+ * @param output The output reference.
+ * @param id The UUID of the request to reply to.
+ * @param rparams A pointer to the MsgPack serialized parameters.
+ * @param rparams_size Size of the serialized parameters.
+ * @param release Called with rparams once the library no longer needs it, may be NULL.
+ * @param userdata A pointer which is passed to release.
+ *
+ * @return error
+ */
+extern int tvio_output_reply_nocopy(int output, char* id, void* rparams, int rparams_size, tvio_release_handler release, void* userdata);
+
+/**
+ * @brief Replies to a request and sends the result to all concerned peers. The UUID is given in its 16 byte binary form, see tvio_input_call_bin.
+ *
+ * @param output The output reference.
+ * @param id The 16 byte binary UUID of the request to reply to.
+ * @param rparams A pointer to the MsgPack serialized parameters.
+ * @param rparams_size Size of the serialized parameters.
+ *
+ * @return error
+ */
+extern int tvio_output_reply_bin(int output, void* id, void* rparams, int rparams_size);
+
+/**
+ * @brief Replies to several requests in one call. The reply parameters are packed into one buffer, the parameters of reply k start at offsets[k] and end at offsets[k+1]. Unknown UUIDs are skipped.
+ *
+ * @param output The output reference.
+ * @param n The number of replies.
+ * @param ids An array of n UUIDs of the requests to reply to.
+ * @param params A pointer to the packed MsgPack serialized parameters.
+ * @param offsets An array of n+1 parameter offsets, starting at 0 and never decreasing.
+ *
+ * @return error, ERR_INVALID_REQUEST_ID if at least one UUID was unknown, ERR_MALFORMED_PARAMETERS if n or the offsets are invalid.
+ */
+extern int tvio_output_reply_batch(int output, int n, char** ids, void* params, int* offsets);
+
+/**
+ * @brief Resolves the name of a function to its id, see tvio_input_function_id.
+ *
+ * @param output The output reference.
+ * @param function Name of the function.
+ * @param id A pointer which will be set to the id of the function.
+ *
+ * @return error, ERR_INVALID_FUNCTION if the descriptor does not declare the function.
+ */
+extern int tvio_output_function_id(int output, char* function, int* id);
+
+/**
+ * @brief Resolves the name of a property to its id, see tvio_input_function_id.
+ *
+ * @param output The output reference.
+ * @param property Name of the property.
+ * @param id A pointer which will be set to the id of the property.
+ *
+ * @return error, ERR_INVALID_PROPERTY if the descriptor does not declare the property.
+ */
+extern int tvio_output_property_id(int output, char* property, int* id);
+
 /**
  * @brief Executes a ThingiverseIO EMIT.
  *
@@ -553,6 +1511,20 @@ extern int tvio_output_reply(int output, char* id, void* rparams, int rparams_si
  */
 extern int tvio_output_emit(int output, char* function, void* in_params, int in_params_size, void* params, int params_size);
 
+/**
+ * @brief Executes a ThingiverseIO EMIT of a function given by id, see tvio_output_function_id.
+ *
+ * @param output The output reference.
+ * @param function The id of the emitted function.
+ * @param in_params The MsgPack serialized input parameters of the emitted function.
+ * @param in_params_size The size of the serialized input parameters.
+ * @param params The MsgPack serialized output parameters of the emitted function.
+ * @param params_size The size of the serialized output parameters.
+ *
+ * @return error
+ */
+extern int tvio_output_emit_id(int output, int function, void* in_params, int in_params_size, void* params, int params_size);
+
 /**
  * @brief Sets the MsgPack serialized value of a property.
  *
@@ -565,6 +1537,18 @@ extern int tvio_output_emit(int output, char* function, void* in_params, int in_
  */
 extern int tvio_output_property_set(int output, char* property, void* value, int value_size);
 
+/**
+ * @brief Sets the MsgPack serialized value of a property given by id, see tvio_output_property_id.
+ *
+ * @param output The output reference.
+ * @param property The id of the property.
+ * @param value The serialized value.
+ * @param value_size The size of the serialized data.
+ *
+ * @return error
+ */
+extern int tvio_output_property_set_id(int output, int property, void* value, int value_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,834 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * @brief Header-only C++17 wrapper of thingiverseio.h.
+ * @file thingiverseio.hpp
+ *
+ * Inputs, outputs, codecs and buffers returned by the library are move-only
+ * and release what they own when destroyed. Parameters are passed as
+ * tvio::bytes_view, which is std::span<const std::byte> with C++20, and
+ * results are returned as tvio::result, which carries either a value or a
+ * tvio::errc. Nothing is allocated beyond what the C API allocates itself,
+ * and the *_into, *_id and *_nocopy functions, property mirrors and the queue
+ * and statistics calls allow hot paths without any allocation.
+ *
+ * Not everything is wrapped: the batch and binary id calls, completions,
+ * request handlers, serve workers and tvio_poll are called through the C API
+ * with handle().
+ */
+
+#ifndef THINGIVERSEIO_HPP
+#define THINGIVERSEIO_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+#include "thingiverseio.h"
+
+namespace tvio {
+
+/**
+ * @brief The error codes of thingiverseio.h.
+ */
+enum class errc : int {
+	ok = 0,
+	network = -1,
+	invalid_descriptor = -2,
+	invalid_input = -3,
+	invalid_output = -4,
+	invalid_result_id = -5,
+	invalid_request_id = -6,
+	no_result_available = -7,
+	no_request_available = -8,
+	result_not_arrived = -9,
+	invalid_function = -10,
+	invalid_property = -11,
+	no_update = -12,
+	not_supported = -13,
+	buffer_too_small = -14,
+	queue_full = -15,
+	invalid_queue = -16,
+	invalid_codec = -17,
+	malformed_parameters = -18,
+};
+
+/**
+ * @brief The error category of errc, messages come from tvio_error_message.
+ */
+class error_category_impl : public std::error_category {
+public:
+	const char* name() const noexcept override { return "thingiverseio"; }
+
+	std::string message(int code) const override {
+		char* msg = nullptr;
+		int size = 0;
+		tvio_error_message(code, &msg, &size);
+		std::string s(msg ? msg : "", static_cast<std::size_t>(size));
+		std::free(msg);
+		return s;
+	}
+};
+
+inline const std::error_category& error_category() noexcept {
+	static const error_category_impl category;
+	return category;
+}
+
+inline std::error_code make_error_code(errc e) noexcept {
+	return {static_cast<int>(e), error_category()};
+}
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+using bytes_view = std::span<const std::byte>;
+using mutable_bytes_view = std::span<std::byte>;
+#else
+/**
+ * @brief A view of bytes, std::span<const std::byte> before C++20.
+ */
+class bytes_view {
+public:
+	constexpr bytes_view() noexcept = default;
+	constexpr bytes_view(const std::byte* data, std::size_t size) noexcept : data_(data), size_(size) {}
+	constexpr const std::byte* data() const noexcept { return data_; }
+	constexpr std::size_t size() const noexcept { return size_; }
+	constexpr bool empty() const noexcept { return size_ == 0; }
+
+private:
+	const std::byte* data_ = nullptr;
+	std::size_t size_ = 0;
+};
+
+/**
+ * @brief A view of writable bytes, std::span<std::byte> before C++20.
+ */
+class mutable_bytes_view {
+public:
+	constexpr mutable_bytes_view() noexcept = default;
+	constexpr mutable_bytes_view(std::byte* data, std::size_t size) noexcept : data_(data), size_(size) {}
+	constexpr std::byte* data() const noexcept { return data_; }
+	constexpr std::size_t size() const noexcept { return size_; }
+
+private:
+	std::byte* data_ = nullptr;
+	std::size_t size_ = 0;
+};
+#endif
+
+/**
+ * @brief Views the bytes of a string.
+ */
+inline bytes_view as_bytes(std::string_view s) noexcept {
+	return {reinterpret_cast<const std::byte*>(s.data()), s.size()};
+}
+
+/**
+ * @brief A value or an error.
+ */
+template <class T>
+class result {
+public:
+	result(T value) noexcept(std::is_nothrow_move_constructible_v<T>) : value_(std::move(value)) {}
+	result(errc err) noexcept : err_(err) {}
+
+	/** @brief True if there is a value. */
+	explicit operator bool() const noexcept { return err_ == errc::ok; }
+	errc error() const noexcept { return err_; }
+	std::error_code error_code() const noexcept { return make_error_code(err_); }
+
+	T& value() & { check(); return value_; }
+	const T& value() const& { check(); return value_; }
+	T&& value() && { check(); return std::move(value_); }
+	T& operator*() & noexcept { return value_; }
+	T&& operator*() && noexcept { return std::move(value_); }
+	T* operator->() noexcept { return &value_; }
+
+private:
+	void check() const {
+		if (err_ != errc::ok) {
+			throw std::system_error(make_error_code(err_));
+		}
+	}
+
+	T value_{};
+	errc err_ = errc::ok;
+};
+
+template <>
+class result<void> {
+public:
+	result() noexcept = default;
+	result(errc err) noexcept : err_(err) {}
+
+	explicit operator bool() const noexcept { return err_ == errc::ok; }
+	errc error() const noexcept { return err_; }
+	std::error_code error_code() const noexcept { return make_error_code(err_); }
+
+	void value() const {
+		if (err_ != errc::ok) {
+			throw std::system_error(make_error_code(err_));
+		}
+	}
+
+private:
+	errc err_ = errc::ok;
+};
+
+namespace detail {
+
+inline errc to_errc(int err) noexcept { return static_cast<errc>(err); }
+
+inline result<void> check(int err) noexcept {
+	return to_errc(err);
+}
+
+inline void* data(bytes_view b) noexcept {
+	return const_cast<std::byte*>(b.data());
+}
+
+inline int size(bytes_view b) noexcept {
+	return static_cast<int>(b.size());
+}
+
+inline char* name(const char* s) noexcept {
+	return const_cast<char*>(s);
+}
+
+} // namespace detail
+
+/**
+ * @brief Memory allocated by the library, freed when the buffer is destroyed.
+ * The buffer never copies, views of it are valid as long as it lives.
+ */
+class Buffer {
+public:
+	Buffer() noexcept = default;
+
+	/** @brief Takes ownership of memory returned by the library. */
+	Buffer(void* data, int size) noexcept : data_(data), size_(size > 0 ? static_cast<std::size_t>(size) : 0) {}
+
+	Buffer(const Buffer&) = delete;
+	Buffer& operator=(const Buffer&) = delete;
+	Buffer(Buffer&& o) noexcept : data_(std::exchange(o.data_, nullptr)), size_(std::exchange(o.size_, 0)) {}
+	Buffer& operator=(Buffer&& o) noexcept {
+		if (this != &o) {
+			std::free(data_);
+			data_ = std::exchange(o.data_, nullptr);
+			size_ = std::exchange(o.size_, 0);
+		}
+		return *this;
+	}
+	~Buffer() { std::free(data_); }
+
+	const std::byte* data() const noexcept { return static_cast<const std::byte*>(data_); }
+	std::size_t size() const noexcept { return size_; }
+	bool empty() const noexcept { return size_ == 0; }
+	bytes_view bytes() const noexcept { return {data(), size_}; }
+	std::string_view str() const noexcept { return {static_cast<const char*>(data_), size_}; }
+
+	/** @brief The memory as zero terminated string, e.g. to pass a UUID back to the library. */
+	const char* c_str() const noexcept { return static_cast<const char*>(data_); }
+
+	/** @brief Gives up ownership, the caller has to free the memory. */
+	void* release() noexcept {
+		size_ = 0;
+		return std::exchange(data_, nullptr);
+	}
+
+private:
+	void* data_ = nullptr;
+	std::size_t size_ = 0;
+};
+
+/**
+ * @brief A request taken from an output. All views point into one buffer.
+ */
+struct Request {
+	Buffer storage;
+	std::string_view id;
+	std::string_view function;
+	bytes_view params;
+};
+
+/**
+ * @brief A listen result taken from an input. All views point into one buffer.
+ */
+struct ListenResult {
+	Buffer storage;
+	std::string_view id;
+	std::string_view function;
+	bytes_view request_params;
+	bytes_view params;
+};
+
+/**
+ * @brief A property change taken from an input. All views point into one buffer.
+ */
+struct Change {
+	Buffer storage;
+	std::string_view property;
+	bytes_view value;
+};
+
+/**
+ * @brief The length and overflow counters of a queue.
+ */
+struct QueueStats {
+	int length = 0;
+	unsigned long long dropped = 0;
+	unsigned long long rejected = 0;
+};
+
+/**
+ * @brief Copies the value of a property mirror into buf, see
+ * tvio_property_mirror_read and take_result_into.
+ */
+inline result<std::size_t> read_mirror(tvio_property_mirror* mirror, mutable_bytes_view buf, int* size = nullptr) noexcept {
+	int n = 0;
+	int err = tvio_property_mirror_read(mirror, buf.data(), static_cast<int>(buf.size()), &n);
+	if (size) {
+		*size = n;
+	}
+	if (err != 0) {
+		return detail::to_errc(err);
+	}
+	return static_cast<std::size_t>(n);
+}
+
+/**
+ * @brief A ThingiverseIO input, removed when destroyed.
+ */
+class Input {
+public:
+	Input() noexcept = default;
+	explicit Input(int handle) noexcept : handle_(handle) {}
+	Input(const Input&) = delete;
+	Input& operator=(const Input&) = delete;
+	Input(Input&& o) noexcept : handle_(std::exchange(o.handle_, -1)) {}
+	Input& operator=(Input&& o) noexcept {
+		if (this != &o) {
+			reset();
+			handle_ = std::exchange(o.handle_, -1);
+		}
+		return *this;
+	}
+	~Input() { reset(); }
+
+	static result<Input> create(const char* descriptor) noexcept {
+		int h = tvio_new_input(detail::name(descriptor));
+		if (h < 0) {
+			return detail::to_errc(h);
+		}
+		return Input(h);
+	}
+
+	int handle() const noexcept { return handle_; }
+
+	void reset() noexcept {
+		if (handle_ >= 0) {
+			tvio_input_remove(handle_);
+			handle_ = -1;
+		}
+	}
+
+	result<bool> connected() const noexcept {
+		int is = 0;
+		int err = tvio_input_connected(handle_, &is);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return is != 0;
+	}
+
+	result<int> fd() const noexcept {
+		int fd = -1;
+		int err = tvio_input_fd(handle_, &fd);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return fd;
+	}
+
+	result<int> function_id(const char* function) const noexcept {
+		int id = -1;
+		int err = tvio_input_function_id(handle_, detail::name(function), &id);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return id;
+	}
+
+	result<int> property_id(const char* property) const noexcept {
+		int id = -1;
+		int err = tvio_input_property_id(handle_, detail::name(property), &id);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return id;
+	}
+
+	/** @brief Executes a CALL, the result holds the request UUID. */
+	result<Buffer> call(const char* function, bytes_view params) noexcept {
+		char* id = nullptr;
+		int id_size = 0;
+		int err = tvio_input_call(handle_, detail::name(function), detail::data(params), detail::size(params), &id, &id_size);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return Buffer(id, id_size);
+	}
+
+	result<Buffer> call(int function, bytes_view params) noexcept {
+		char* id = nullptr;
+		int id_size = 0;
+		int err = tvio_input_call_id(handle_, function, detail::data(params), detail::size(params), &id, &id_size);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return Buffer(id, id_size);
+	}
+
+	/** @brief Executes a CALL, the binary request UUID is written to id. */
+	result<void> call_bin(const char* function, bytes_view params, std::byte (&id)[16]) noexcept {
+		return detail::check(tvio_input_call_bin(handle_, detail::name(function), detail::data(params), detail::size(params), id));
+	}
+
+	result<Buffer> call_all(const char* function, bytes_view params) noexcept {
+		char* id = nullptr;
+		int id_size = 0;
+		int err = tvio_input_call_all(handle_, detail::name(function), detail::data(params), detail::size(params), &id, &id_size);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return Buffer(id, id_size);
+	}
+
+	result<void> trigger(const char* function, bytes_view params) noexcept {
+		return detail::check(tvio_input_trigger(handle_, detail::name(function), detail::data(params), detail::size(params)));
+	}
+
+	result<void> trigger(int function, bytes_view params) noexcept {
+		return detail::check(tvio_input_trigger_id(handle_, function, detail::data(params), detail::size(params)));
+	}
+
+	result<void> trigger_all(const char* function, bytes_view params) noexcept {
+		return detail::check(tvio_input_trigger_all(handle_, detail::name(function), detail::data(params), detail::size(params)));
+	}
+
+	result<bool> result_available(const char* id) const noexcept {
+		int is = 0;
+		int err = tvio_input_call_result_available(handle_, detail::name(id), &is);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return is != 0;
+	}
+
+	result<bool> wait_result(const char* id, std::chrono::milliseconds timeout) noexcept {
+		int ready = 0;
+		int err = tvio_input_call_result_wait(handle_, detail::name(id), static_cast<int>(timeout.count()), &ready);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return ready != 0;
+	}
+
+	/** @brief Retrieves and clears the result of a CALL. */
+	result<Buffer> take_result(const char* id) noexcept {
+		void* params = nullptr;
+		int size = 0;
+		int err = tvio_input_call_result_params(handle_, detail::name(id), &params, &size);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return Buffer(params, size);
+	}
+
+	/**
+	 * @brief Copies the result of a CALL into buf and clears it. Returns the
+	 * size of the result, with errc::buffer_too_small the result is kept and
+	 * size is set to the required size.
+	 */
+	result<std::size_t> take_result_into(const char* id, mutable_bytes_view buf, int* size = nullptr) noexcept {
+		int n = 0;
+		int err = tvio_input_call_result_params_into(handle_, detail::name(id), buf.data(), static_cast<int>(buf.size()), &n);
+		if (size) {
+			*size = n;
+		}
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return static_cast<std::size_t>(n);
+	}
+
+	result<void> listen_start(const char* function) noexcept {
+		return detail::check(tvio_input_listen_start(handle_, detail::name(function)));
+	}
+
+	result<void> listen_stop(const char* function) noexcept {
+		return detail::check(tvio_input_listen_stop(handle_, detail::name(function)));
+	}
+
+	result<bool> wait_listen(std::chrono::milliseconds timeout) noexcept {
+		int is = 0;
+		int err = tvio_input_listen_result_wait(handle_, static_cast<int>(timeout.count()), &is);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return is != 0;
+	}
+
+	result<ListenResult> take_listen() noexcept {
+		char *id = nullptr, *function = nullptr;
+		void *request_params = nullptr, *params = nullptr;
+		int request_params_size = 0, params_size = 0;
+		int err = tvio_input_listen_result_take(handle_, &id, &function, &request_params, &request_params_size, &params, &params_size);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		ListenResult r;
+		r.id = id;
+		r.function = function;
+		r.request_params = {static_cast<const std::byte*>(request_params), static_cast<std::size_t>(request_params_size)};
+		r.params = {static_cast<const std::byte*>(params), static_cast<std::size_t>(params_size)};
+		r.storage = Buffer(id, 0);
+		return r;
+	}
+
+	result<void> observe_start(const char* property, bool coalesced = false) noexcept {
+		if (coalesced) {
+			return detail::check(tvio_input_change_start_observe_coalesced(handle_, detail::name(property)));
+		}
+		return detail::check(tvio_input_change_start_observe(handle_, detail::name(property)));
+	}
+
+	result<void> observe_stop(const char* property) noexcept {
+		return detail::check(tvio_input_change_stop_observe(handle_, detail::name(property)));
+	}
+
+	result<bool> wait_change(std::chrono::milliseconds timeout) noexcept {
+		int is = 0;
+		int err = tvio_input_change_wait(handle_, static_cast<int>(timeout.count()), &is);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return is != 0;
+	}
+
+	result<Change> take_change() noexcept {
+		char* property = nullptr;
+		void* value = nullptr;
+		int value_size = 0;
+		int err = tvio_input_change_take(handle_, &property, &value, &value_size);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		Change c;
+		c.property = property;
+		c.value = {static_cast<const std::byte*>(value), static_cast<std::size_t>(value_size)};
+		c.storage = Buffer(property, 0);
+		return c;
+	}
+
+	result<Buffer> property(const char* property) noexcept {
+		void* value = nullptr;
+		int size = 0;
+		int err = tvio_input_property_get(handle_, detail::name(property), &value, &size);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return Buffer(value, size);
+	}
+
+	/** @brief Copies the value of a property into buf, see take_result_into. */
+	result<std::size_t> property_into(int property, mutable_bytes_view buf, int* size = nullptr) noexcept {
+		int n = 0;
+		int err = tvio_input_property_get_into_id(handle_, property, buf.data(), static_cast<int>(buf.size()), &n);
+		if (size) {
+			*size = n;
+		}
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return static_cast<std::size_t>(n);
+	}
+
+	/** @brief Mirrors a property, read it with read_mirror. The input owns the mirror. */
+	result<tvio_property_mirror*> property_mirror(const char* property, int capacity) noexcept {
+		tvio_property_mirror* mirror = nullptr;
+		int err = tvio_input_property_mirror(handle_, detail::name(property), capacity, &mirror);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return mirror;
+	}
+
+	/** @brief Bounds TVIO_QUEUE_LISTEN or TVIO_QUEUE_CHANGE, see tvio_input_queue_set. */
+	result<void> queue_set(int queue, int capacity, int policy) noexcept {
+		return detail::check(tvio_input_queue_set(handle_, queue, capacity, policy));
+	}
+
+	result<QueueStats> queue_stats(int queue) const noexcept {
+		QueueStats q;
+		int err = tvio_input_queue_stats(handle_, queue, &q.length, &q.dropped, &q.rejected);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return q;
+	}
+
+	result<tvio_input_statistics> stats() const noexcept {
+		tvio_input_statistics s;
+		int err = tvio_input_stats(handle_, &s);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return s;
+	}
+
+private:
+	int handle_ = -1;
+};
+
+/**
+ * @brief A ThingiverseIO output, removed when destroyed.
+ */
+class Output {
+public:
+	Output() noexcept = default;
+	explicit Output(int handle) noexcept : handle_(handle) {}
+	Output(const Output&) = delete;
+	Output& operator=(const Output&) = delete;
+	Output(Output&& o) noexcept : handle_(std::exchange(o.handle_, -1)) {}
+	Output& operator=(Output&& o) noexcept {
+		if (this != &o) {
+			reset();
+			handle_ = std::exchange(o.handle_, -1);
+		}
+		return *this;
+	}
+	~Output() { reset(); }
+
+	static result<Output> create(const char* descriptor) noexcept {
+		int h = tvio_new_output(detail::name(descriptor));
+		if (h < 0) {
+			return detail::to_errc(h);
+		}
+		return Output(h);
+	}
+
+	int handle() const noexcept { return handle_; }
+
+	void reset() noexcept {
+		if (handle_ >= 0) {
+			tvio_output_remove(handle_);
+			handle_ = -1;
+		}
+	}
+
+	result<bool> connected() const noexcept {
+		int is = 0;
+		int err = tvio_output_connected(handle_, &is);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return is != 0;
+	}
+
+	result<int> fd() const noexcept {
+		int fd = -1;
+		int err = tvio_output_fd(handle_, &fd);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return fd;
+	}
+
+	result<int> function_id(const char* function) const noexcept {
+		int id = -1;
+		int err = tvio_output_function_id(handle_, detail::name(function), &id);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return id;
+	}
+
+	result<int> property_id(const char* property) const noexcept {
+		int id = -1;
+		int err = tvio_output_property_id(handle_, detail::name(property), &id);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return id;
+	}
+
+	result<bool> wait_request(std::chrono::milliseconds timeout) noexcept {
+		int is = 0;
+		int err = tvio_output_request_wait(handle_, static_cast<int>(timeout.count()), &is);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return is != 0;
+	}
+
+	result<Request> take_request() noexcept {
+		char *id = nullptr, *function = nullptr;
+		void* params = nullptr;
+		int params_size = 0;
+		int err = tvio_output_request_take(handle_, &id, &function, &params, &params_size);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		Request r;
+		r.id = id;
+		r.function = function;
+		r.params = {static_cast<const std::byte*>(params), static_cast<std::size_t>(params_size)};
+		r.storage = Buffer(id, 0);
+		return r;
+	}
+
+	/** @brief Replies to a request, id must be zero terminated like the ids of Request. */
+	result<void> reply(std::string_view id, bytes_view params) noexcept {
+		return detail::check(tvio_output_reply(handle_, const_cast<char*>(id.data()), detail::data(params), detail::size(params)));
+	}
+
+	result<void> emit(const char* function, bytes_view in_params, bytes_view params) noexcept {
+		return detail::check(tvio_output_emit(handle_, detail::name(function), detail::data(in_params), detail::size(in_params), detail::data(params), detail::size(params)));
+	}
+
+	result<void> emit(int function, bytes_view in_params, bytes_view params) noexcept {
+		return detail::check(tvio_output_emit_id(handle_, function, detail::data(in_params), detail::size(in_params), detail::data(params), detail::size(params)));
+	}
+
+	result<void> set_property(const char* property, bytes_view value) noexcept {
+		return detail::check(tvio_output_property_set(handle_, detail::name(property), detail::data(value), detail::size(value)));
+	}
+
+	result<void> set_property(int property, bytes_view value) noexcept {
+		return detail::check(tvio_output_property_set_id(handle_, property, detail::data(value), detail::size(value)));
+	}
+
+	/** @brief Replies without copying where the transport allows it, see tvio_output_reply_nocopy. */
+	result<void> reply_nocopy(std::string_view id, bytes_view params, tvio_release_handler release, void* userdata) noexcept {
+		return detail::check(tvio_output_reply_nocopy(handle_, const_cast<char*>(id.data()), detail::data(params), detail::size(params), release, userdata));
+	}
+
+	/** @brief Bounds the request queue, see tvio_output_queue_set. */
+	result<void> queue_set(int capacity, int policy) noexcept {
+		return detail::check(tvio_output_queue_set(handle_, capacity, policy));
+	}
+
+	result<QueueStats> queue_stats() const noexcept {
+		QueueStats q;
+		int err = tvio_output_queue_stats(handle_, &q.length, &q.dropped, &q.rejected);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return q;
+	}
+
+	result<tvio_output_statistics> stats() const noexcept {
+		tvio_output_statistics s;
+		int err = tvio_output_stats(handle_, &s);
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return s;
+	}
+
+private:
+	int handle_ = -1;
+};
+
+/**
+ * @brief A codec compiled from a descriptor, see tvio_codec_new. T is the
+ * struct the parameters are packed from and unpacked into.
+ */
+template <class T>
+class Codec {
+public:
+	Codec() noexcept = default;
+	Codec(const Codec&) = delete;
+	Codec& operator=(const Codec&) = delete;
+	Codec(Codec&& o) noexcept : handle_(std::exchange(o.handle_, -1)) {}
+	Codec& operator=(Codec&& o) noexcept {
+		if (this != &o) {
+			reset();
+			handle_ = std::exchange(o.handle_, -1);
+		}
+		return *this;
+	}
+	~Codec() { reset(); }
+
+	/** @brief Compiles a codec, offsets are the offsetof(T, ...) of every parameter in declaration order. */
+	template <std::size_t N>
+	static result<Codec> create(const char* descriptor, const char* function, int list, const int (&offsets)[N]) noexcept {
+		int h = tvio_codec_new(detail::name(descriptor), detail::name(function), list, const_cast<int*>(offsets), static_cast<int>(N));
+		if (h < 0) {
+			return detail::to_errc(h);
+		}
+		Codec c;
+		c.handle_ = h;
+		return c;
+	}
+
+	void reset() noexcept {
+		if (handle_ >= 0) {
+			tvio_codec_remove(handle_);
+			handle_ = -1;
+		}
+	}
+
+	/** @brief Packs src into buf and returns the packed bytes, see tvio_codec_pack. */
+	result<bytes_view> pack(const T& src, mutable_bytes_view buf, int* size = nullptr) const noexcept {
+		int n = 0;
+		int err = tvio_codec_pack(handle_, const_cast<T*>(&src), buf.data(), static_cast<int>(buf.size()), &n);
+		if (size) {
+			*size = n;
+		}
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		return bytes_view{buf.data(), static_cast<std::size_t>(n)};
+	}
+
+	/** @brief Unpacks data into dst, string and bin fields point into data. */
+	result<void> unpack(bytes_view data, T& dst) const noexcept {
+		return detail::check(tvio_codec_unpack(handle_, detail::data(data), detail::size(data), &dst));
+	}
+
+private:
+	int handle_ = -1;
+};
+
+} // namespace tvio
+
+namespace std {
+template <>
+struct is_error_code_enum<tvio::errc> : true_type {};
+} // namespace std
+
+#endif
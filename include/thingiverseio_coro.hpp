@@ -0,0 +1,427 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * @brief C++20 coroutine support for thingiverseio.hpp.
+ * @file thingiverseio_coro.hpp
+ *
+ * tvio::AsyncInput and tvio::AsyncOutput make CALL results and requests
+ * awaitable:
+ *
+ *     auto result = co_await input.call("SayHello", params);
+ *     auto request = co_await output.next_request();
+ *
+ * Awaiting coroutines are suspended until the library signals new data on
+ * the descriptor returned by fd(). Register it with the host's epoll loop
+ * and call dispatch() whenever it becomes readable, or call dispatch() after
+ * tvio_poll reported the handle on platforms without descriptors. dispatch()
+ * resumes the coroutines whose data arrived, inline or through the executor
+ * given on construction. One thread can so keep any number of CALLs in
+ * flight.
+ */
+
+#ifndef THINGIVERSEIO_CORO_HPP
+#define THINGIVERSEIO_CORO_HPP
+
+#include <array>
+#include <coroutine>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "thingiverseio.hpp"
+
+namespace tvio {
+
+/**
+ * @brief Resumes a coroutine, e.g. by posting it to a thread pool. Without an
+ * executor dispatch() resumes coroutines itself.
+ */
+using executor = void (*)(std::coroutine_handle<> coroutine, void* userdata);
+
+/**
+ * @brief A fire and forget coroutine, for coroutines which are not awaited.
+ */
+struct detached {
+	struct promise_type {
+		detached get_return_object() noexcept { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+	};
+};
+
+namespace detail {
+
+using request_key = std::array<std::byte, 16>;
+
+// Request UUIDs are random, so any 8 of their bytes are a good hash.
+struct request_key_hash {
+	std::size_t operator()(const request_key& k) const noexcept {
+		std::size_t h;
+		std::memcpy(&h, k.data(), sizeof(h));
+		return h;
+	}
+};
+
+// reset reads the eventfd of a handle, which resets it before the handle is
+// drained.
+inline void reset(int fd) noexcept {
+#ifndef _WIN32
+	if (fd >= 0) {
+		unsigned long long v;
+		if (::read(fd, &v, sizeof(v)) < 0) {
+			return;
+		}
+	}
+#endif
+}
+
+// copy duplicates one result of a batch into a buffer of its own.
+inline Buffer copy(const std::byte* data, int size) {
+	void* p = std::malloc(size > 0 ? static_cast<std::size_t>(size) : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	std::memcpy(p, data, static_cast<std::size_t>(size));
+	return Buffer(p, size);
+}
+
+struct resumer {
+	executor exec;
+	void* userdata;
+
+	void operator()(std::coroutine_handle<> h) const {
+		if (exec) {
+			exec(h, userdata);
+		} else {
+			h.resume();
+		}
+	}
+};
+
+} // namespace detail
+
+/**
+ * @brief Awaitable CALLs of an input. The input must outlive it, and all
+ * awaited CALLs must have completed before it is destroyed.
+ *
+ * It enables the completion queue of the input, so results of CALLs issued
+ * directly through the input are queued as well; dispatch() drops them.
+ */
+class AsyncInput {
+public:
+	/**
+	 * @brief A CALL, issued when it is awaited. Awaiting it returns the
+	 * result parameters. The parameters must stay valid until then.
+	 */
+	class CallAwaitable {
+	public:
+		CallAwaitable(const CallAwaitable&) = delete;
+		CallAwaitable& operator=(const CallAwaitable&) = delete;
+
+		bool await_ready() const noexcept { return false; }
+
+		bool await_suspend(std::coroutine_handle<> h) {
+			coroutine_ = h;
+			return owner_->suspend(this);
+		}
+
+		result<Buffer> await_resume() noexcept {
+			if (err_ != errc::ok) {
+				return err_;
+			}
+			return std::move(result_);
+		}
+
+	private:
+		friend class AsyncInput;
+
+		CallAwaitable(AsyncInput* owner, const char* function, int id, bytes_view params) noexcept
+			: owner_(owner), function_(function), id_(id), params_(params) {}
+
+		AsyncInput* owner_;
+		const char* function_;
+		int id_;
+		bytes_view params_;
+		errc err_ = errc::ok;
+		detail::request_key key_{};
+		std::coroutine_handle<> coroutine_;
+		Buffer result_;
+	};
+
+	explicit AsyncInput(Input& input, executor exec = nullptr, void* userdata = nullptr) noexcept
+		: input_(input), resume_{exec, userdata} {}
+
+	AsyncInput(const AsyncInput&) = delete;
+	AsyncInput& operator=(const AsyncInput&) = delete;
+
+	/**
+	 * @brief Enables the completion queue of the input and looks up its
+	 * descriptor. Must be called once before the first CALL.
+	 */
+	result<void> start() noexcept {
+		int err = tvio_input_completions_start(input_.handle());
+		if (err != 0) {
+			return detail::to_errc(err);
+		}
+		if (auto fd = input_.fd()) {
+			fd_ = *fd;
+		}
+		return {};
+	}
+
+	/** @brief The eventfd of the input, -1 where descriptors are not supported. */
+	int fd() const noexcept { return fd_; }
+
+	CallAwaitable call(const char* function, bytes_view params) noexcept {
+		return CallAwaitable(this, function, -1, params);
+	}
+
+	/** @brief A CALL of a function given by id, see Input::function_id. */
+	CallAwaitable call(int function, bytes_view params) noexcept {
+		return CallAwaitable(this, nullptr, function, params);
+	}
+
+	/**
+	 * @brief Retrieves all completed CALLs and resumes the coroutines
+	 * awaiting them.
+	 */
+	void dispatch() {
+		constexpr int batch = 32;
+		detail::reset(fd_);
+		for (;;) {
+			std::byte ids[16 * batch];
+			int offsets[batch + 1];
+			void* params = nullptr;
+			int n = 0;
+			// Fails with ERR_RESULT_NOT_ARRIVED once the queue is drained,
+			// stale entries are skipped by the library.
+			if (tvio_input_completions_take(input_.handle(), batch, ids, offsets, &params, &n) != 0 || n == 0) {
+				return;
+			}
+			Buffer all(params, offsets[n]);
+			for (int k = 0; k < n; k++) {
+				detail::request_key key;
+				std::memcpy(key.data(), ids + 16 * k, key.size());
+				CallAwaitable* a;
+				{
+					std::lock_guard<std::mutex> lock(m_);
+					auto it = waiting_.find(key);
+					if (it == waiting_.end()) {
+						if (issuing_ > 0) {
+							// May belong to a CALL which is not registered yet.
+							arrived_.emplace(key, detail::copy(all.data() + offsets[k], offsets[k + 1] - offsets[k]));
+						}
+						continue;
+					}
+					a = it->second;
+					waiting_.erase(it);
+				}
+				if (offsets[k] == offsets[k + 1]) {
+					a->err_ = failure(ids + 16 * k);
+				}
+				a->result_ = detail::copy(all.data() + offsets[k], offsets[k + 1] - offsets[k]);
+				resume_(a->coroutine_);
+			}
+		}
+	}
+
+	/** @brief The number of CALLs awaited and not completed yet. */
+	std::size_t pending() const {
+		std::lock_guard<std::mutex> lock(m_);
+		return waiting_.size();
+	}
+
+private:
+	// failure returns the error of a completion with empty parameters. Failed
+	// CALLs are kept by the library, successful ones are already cleared.
+	errc failure(std::byte* id) noexcept {
+		void* params = nullptr;
+		int size = 0;
+		int err = tvio_input_call_result_params_bin(input_.handle(), id, &params, &size);
+		if (err == 0) {
+			std::free(params);
+		}
+		if (err == 0 || detail::to_errc(err) == errc::invalid_result_id) {
+			return errc::ok;
+		}
+		return detail::to_errc(err);
+	}
+
+	// suspend issues a CALL and registers it. The CALL is issued without
+	// holding m_, results arriving before it is registered are kept in
+	// arrived_ while any CALL is being issued.
+	bool suspend(CallAwaitable* a) {
+		{
+			std::lock_guard<std::mutex> lock(m_);
+			issuing_++;
+		}
+		int err;
+		if (a->function_) {
+			err = tvio_input_call_bin(input_.handle(), detail::name(a->function_), detail::data(a->params_), detail::size(a->params_), a->key_.data());
+		} else {
+			err = tvio_input_call_id_bin(input_.handle(), a->id_, detail::data(a->params_), detail::size(a->params_), a->key_.data());
+		}
+		std::lock_guard<std::mutex> lock(m_);
+		issuing_--;
+		bool suspended = false;
+		if (err != 0) {
+			a->err_ = detail::to_errc(err);
+		} else if (auto it = arrived_.find(a->key_); it != arrived_.end()) {
+			a->result_ = std::move(it->second);
+			arrived_.erase(it);
+			if (a->result_.empty()) {
+				a->err_ = failure(a->key_.data());
+			}
+		} else {
+			waiting_.emplace(a->key_, a);
+			suspended = true;
+		}
+		if (issuing_ == 0) {
+			// Whatever is left belongs to CALLs issued directly.
+			arrived_.clear();
+		}
+		return suspended;
+	}
+
+	Input& input_;
+	detail::resumer resume_;
+	int fd_ = -1;
+	mutable std::mutex m_;
+	std::unordered_map<detail::request_key, CallAwaitable*, detail::request_key_hash> waiting_;
+	std::unordered_map<detail::request_key, Buffer, detail::request_key_hash> arrived_;
+	int issuing_ = 0;
+};
+
+/**
+ * @brief Awaitable requests of an output. The output must outlive it, and
+ * all awaiting coroutines must have been resumed before it is destroyed.
+ * Requests are handed to awaiting coroutines in the order they awaited.
+ */
+class AsyncOutput {
+public:
+	/**
+	 * @brief Awaiting it returns the next request of the output.
+	 */
+	class RequestAwaitable {
+	public:
+		RequestAwaitable(const RequestAwaitable&) = delete;
+		RequestAwaitable& operator=(const RequestAwaitable&) = delete;
+
+		// Requests are only taken in suspend, under the lock which orders
+		// the waiting coroutines.
+		bool await_ready() const noexcept { return false; }
+
+		bool await_suspend(std::coroutine_handle<> h) {
+			coroutine_ = h;
+			return owner_->suspend(this);
+		}
+
+		Request await_resume() noexcept { return std::move(request_); }
+
+	private:
+		friend class AsyncOutput;
+
+		explicit RequestAwaitable(AsyncOutput* owner) noexcept : owner_(owner) {}
+
+		AsyncOutput* owner_;
+		std::coroutine_handle<> coroutine_;
+		Request request_;
+	};
+
+	explicit AsyncOutput(Output& output, executor exec = nullptr, void* userdata = nullptr) noexcept
+		: output_(output), resume_{exec, userdata} {
+		if (auto fd = output_.fd()) {
+			fd_ = *fd;
+		}
+	}
+
+	AsyncOutput(const AsyncOutput&) = delete;
+	AsyncOutput& operator=(const AsyncOutput&) = delete;
+
+	/** @brief The eventfd of the output, -1 where descriptors are not supported. */
+	int fd() const noexcept { return fd_; }
+
+	RequestAwaitable next_request() noexcept { return RequestAwaitable(this); }
+
+	/**
+	 * @brief Hands pending requests to the coroutines awaiting them and
+	 * resumes those.
+	 */
+	void dispatch() {
+		detail::reset(fd_);
+		std::vector<RequestAwaitable*> ready;
+		{
+			std::lock_guard<std::mutex> lock(m_);
+			while (!waiting_.empty()) {
+				auto r = output_.take_request();
+				if (!r) {
+					break;
+				}
+				RequestAwaitable* a = waiting_.front();
+				waiting_.pop_front();
+				a->request_ = std::move(*r);
+				ready.push_back(a);
+			}
+		}
+		for (RequestAwaitable* a : ready) {
+			resume_(a->coroutine_);
+		}
+	}
+
+	/** @brief The number of coroutines awaiting a request. */
+	std::size_t pending() const {
+		std::lock_guard<std::mutex> lock(m_);
+		return waiting_.size();
+	}
+
+private:
+	// suspend takes a request right away if no other coroutine is waiting,
+	// otherwise it queues the coroutine. Requests arriving after it is queued
+	// signal the fd.
+	bool suspend(RequestAwaitable* a) {
+		std::lock_guard<std::mutex> lock(m_);
+		if (waiting_.empty()) {
+			if (auto r = output_.take_request()) {
+				a->request_ = std::move(*r);
+				return false;
+			}
+		}
+		waiting_.push_back(a);
+		return true;
+	}
+
+	Output& output_;
+	detail::resumer resume_;
+	int fd_ = -1;
+	mutable std::mutex m_;
+	std::deque<RequestAwaitable*> waiting_;
+};
+
+} // namespace tvio
+
+#endif
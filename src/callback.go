@@ -0,0 +1,85 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+/*
+#include <stdlib.h>
+
+typedef void (*request_handler)(int output, char* id, char* function, void* params, int params_size, void* userdata);
+
+static void call_request_handler(void* handler, int output, char* id, char* function, void* params, int params_size, void* userdata) {
+	((request_handler)handler)(output, id, function, params, params_size, userdata);
+}
+
+typedef void (*serve_handler)(int output, int worker, int function, void* params, int params_size, void** reply, int* reply_size, void* userdata);
+
+static void call_serve_handler(void* handler, int output, int worker, int function, void* params, int params_size, void** reply, int* reply_size, void* userdata) {
+	((serve_handler)handler)(output, worker, function, params, params_size, reply, reply_size, userdata);
+}
+
+typedef void (*release_handler)(void* data, void* userdata);
+
+static void call_release_handler(void* handler, void* data, void* userdata) {
+	((release_handler)handler)(data, userdata);
+}
+*/
+import "C"
+
+import "unsafe"
+
+// callRequestHandler invokes a C request handler. The parameters are passed
+// without copying and are only valid while the handler runs.
+func callRequestHandler(handler unsafe.Pointer, userdata unsafe.Pointer, o C.int, req *request) {
+	id := C.CString(string(req.UUID))
+	defer C.free(unsafe.Pointer(id))
+	function := C.CString(req.Function)
+	defer C.free(unsafe.Pointer(function))
+	p := req.Parameter()
+	var params unsafe.Pointer
+	if len(p) != 0 {
+		params = unsafe.Pointer(&p[0])
+	}
+	C.call_request_handler(handler, o, id, function, params, C.int(len(p)), userdata)
+}
+
+// callServeHandler invokes a C serve handler and returns the reply it
+// allocated. The parameters are passed without copying.
+func callServeHandler(handler unsafe.Pointer, userdata unsafe.Pointer, o C.int, worker C.int, function C.int, req *request) (reply []byte) {
+	p := req.Parameter()
+	var params unsafe.Pointer
+	if len(p) != 0 {
+		params = unsafe.Pointer(&p[0])
+	}
+	var r unsafe.Pointer
+	var size C.int
+	C.call_serve_handler(handler, o, worker, function, params, C.int(len(p)), &r, &size, userdata)
+	if r != nil {
+		reply = C.GoBytes(r, size)
+		C.free(r)
+	}
+	return
+}
+
+// callReleaseHandler hands a buffer which was sent without copying back to
+// the host. A nil handler is ignored.
+func callReleaseHandler(handler unsafe.Pointer, data unsafe.Pointer, userdata unsafe.Pointer) {
+	if handler == nil {
+		return
+	}
+	C.call_release_handler(handler, data, userdata)
+}
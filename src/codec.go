@@ -0,0 +1,627 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import "C"
+
+import (
+	"encoding/binary"
+	"math"
+	"unsafe"
+
+	"github.com/ThingiverseIO/thingiverseio/descriptor"
+)
+
+// Parameter lists a codec is compiled for, they mirror the TVIO_CODEC_*
+// defines in thingiverseio.h.
+const (
+	CODEC_INPUT C.int = iota
+	CODEC_OUTPUT
+)
+
+// Field types of a codec and the C type they are stored as in the host's
+// struct.
+const (
+	fieldInt   = iota // int64_t
+	fieldFloat        // double
+	fieldBool         // bool
+	fieldBytes        // tvio_codec_bytes, for string and bin
+)
+
+var fieldTypes = map[string]int{
+	"int":     fieldInt,
+	"int8":    fieldInt,
+	"int16":   fieldInt,
+	"int32":   fieldInt,
+	"int64":   fieldInt,
+	"uint":    fieldInt,
+	"uint8":   fieldInt,
+	"uint16":  fieldInt,
+	"uint32":  fieldInt,
+	"uint64":  fieldInt,
+	"float":   fieldFloat,
+	"float32": fieldFloat,
+	"float64": fieldFloat,
+	"bool":    fieldBool,
+	"string":  fieldBytes,
+	"bin":     fieldBytes,
+	"bytes":   fieldBytes,
+}
+
+// codecBytes mirrors tvio_codec_bytes.
+type codecBytes struct {
+	data unsafe.Pointer
+	size C.int
+}
+
+type codecField struct {
+	name   string
+	key    []byte // the name, already encoded
+	typ    int
+	offset uintptr
+}
+
+// codec packs and unpacks the MsgPack map of a parameter list directly from
+// and into a struct of the host, whose layout is given by the offset of each
+// parameter. It is compiled once from the descriptor and immutable after.
+type codec struct {
+	fields []codecField
+	header []byte
+}
+
+func newCodec(desc string, function string, list C.int, offsets []C.int) (c *codec, err C.int) {
+	d, derr := descriptor.Parse(desc)
+	if derr != nil {
+		err = ERR_INVALID_DESCRIPTOR.asInt()
+		return
+	}
+	var params []descriptor.Parameter
+	found := false
+	for _, f := range d.Functions {
+		if f.Name == function {
+			found = true
+			switch list {
+			case CODEC_INPUT:
+				params = f.Input
+			case CODEC_OUTPUT:
+				params = f.Output
+			default:
+				err = ERR_INVALID_CODEC.asInt()
+				return
+			}
+		}
+	}
+	if !found {
+		err = ERR_INVALID_FUNCTION.asInt()
+		return
+	}
+	if len(params) != len(offsets) {
+		err = ERR_INVALID_CODEC.asInt()
+		return
+	}
+	c = &codec{header: appendMapHeader(nil, len(params))}
+	for n, p := range params {
+		typ, ok := fieldTypes[p.Type]
+		if !ok || offsets[n] < 0 {
+			err = ERR_INVALID_CODEC.asInt()
+			return
+		}
+		c.fields = append(c.fields, codecField{
+			name:   p.Name,
+			key:    appendStr(nil, []byte(p.Name)),
+			typ:    typ,
+			offset: uintptr(offsets[n]),
+		})
+	}
+	return
+}
+
+// size returns the encoded size of the struct at src. It fails if a string or
+// bin field has a negative size, or no data but a positive size.
+func (c *codec) size(src unsafe.Pointer) (n int, ok bool) {
+	n = len(c.header)
+	for _, f := range c.fields {
+		n += len(f.key)
+		p := unsafe.Add(src, f.offset)
+		switch f.typ {
+		case fieldInt:
+			n += intSize(*(*int64)(p))
+		case fieldFloat:
+			n += 9
+		case fieldBool:
+			n++
+		case fieldBytes:
+			b := (*codecBytes)(p)
+			if b.size < 0 || (b.size > 0 && b.data == nil) {
+				return
+			}
+			n += strHeaderSize(int(b.size)) + int(b.size)
+		}
+	}
+	ok = true
+	return
+}
+
+// pack encodes the struct at src into buf, which must hold size(src) bytes.
+// size must have accepted src.
+func (c *codec) pack(src unsafe.Pointer, buf []byte) {
+	buf = append(buf[:0], c.header...)
+	for _, f := range c.fields {
+		buf = append(buf, f.key...)
+		p := unsafe.Add(src, f.offset)
+		switch f.typ {
+		case fieldInt:
+			buf = appendInt(buf, *(*int64)(p))
+		case fieldFloat:
+			buf = append(buf, 0xcb)
+			buf = binary.BigEndian.AppendUint64(buf, math.Float64bits(*(*float64)(p)))
+		case fieldBool:
+			if *(*bool)(p) {
+				buf = append(buf, 0xc3)
+			} else {
+				buf = append(buf, 0xc2)
+			}
+		case fieldBytes:
+			b := (*codecBytes)(p)
+			buf = appendStr(buf, unsafe.Slice((*byte)(b.data), int(b.size)))
+		}
+	}
+}
+
+// unpack decodes data into the struct at dst. Parameters are matched by name,
+// unknown ones are skipped and fields without a parameter are left as they
+// are. Strings and bins point into data.
+func (c *codec) unpack(data []byte, dst unsafe.Pointer) (err C.int) {
+	r := msgpackReader{data: data}
+	n, ok := r.mapHeader()
+	if !ok {
+		return ERR_MALFORMED_PARAMETERS.asInt()
+	}
+	for ; n > 0; n-- {
+		key, ok := r.str()
+		if !ok {
+			return ERR_MALFORMED_PARAMETERS.asInt()
+		}
+		f := c.field(key)
+		if f == nil {
+			if !r.skip() {
+				return ERR_MALFORMED_PARAMETERS.asInt()
+			}
+			continue
+		}
+		p := unsafe.Add(dst, f.offset)
+		switch f.typ {
+		case fieldInt:
+			*(*int64)(p), ok = r.int()
+		case fieldFloat:
+			*(*float64)(p), ok = r.float()
+		case fieldBool:
+			*(*bool)(p), ok = r.bool()
+		case fieldBytes:
+			var b []byte
+			if b, ok = r.str(); ok {
+				*(*codecBytes)(p) = codecBytes{unsafe.Pointer(unsafe.SliceData(b)), C.int(len(b))}
+			}
+		}
+		if !ok {
+			return ERR_MALFORMED_PARAMETERS.asInt()
+		}
+	}
+	return
+}
+
+func (c *codec) field(key []byte) *codecField {
+	for n := range c.fields {
+		if c.fields[n].name == string(key) {
+			return &c.fields[n]
+		}
+	}
+	return nil
+}
+
+func appendMapHeader(buf []byte, n int) []byte {
+	switch {
+	case n < 16:
+		return append(buf, 0x80|byte(n))
+	case n <= math.MaxUint16:
+		return binary.BigEndian.AppendUint16(append(buf, 0xde), uint16(n))
+	default:
+		return binary.BigEndian.AppendUint32(append(buf, 0xdf), uint32(n))
+	}
+}
+
+func strHeaderSize(n int) int {
+	switch {
+	case n < 32:
+		return 1
+	case n <= math.MaxUint8:
+		return 2
+	case n <= math.MaxUint16:
+		return 3
+	default:
+		return 5
+	}
+}
+
+func appendStr(buf []byte, s []byte) []byte {
+	n := len(s)
+	switch {
+	case n < 32:
+		buf = append(buf, 0xa0|byte(n))
+	case n <= math.MaxUint8:
+		buf = append(buf, 0xd9, byte(n))
+	case n <= math.MaxUint16:
+		buf = binary.BigEndian.AppendUint16(append(buf, 0xda), uint16(n))
+	default:
+		buf = binary.BigEndian.AppendUint32(append(buf, 0xdb), uint32(n))
+	}
+	return append(buf, s...)
+}
+
+func intSize(v int64) int {
+	switch {
+	case v >= -32 && v <= math.MaxInt8:
+		return 1
+	case v >= math.MinInt8 && v <= math.MaxUint8:
+		return 2
+	case v >= math.MinInt16 && v <= math.MaxUint16:
+		return 3
+	case v >= math.MinInt32 && v <= math.MaxUint32:
+		return 5
+	default:
+		return 9
+	}
+}
+
+// appendInt uses the smallest encoding, like msgpack-c does.
+func appendInt(buf []byte, v int64) []byte {
+	switch {
+	case v >= -32 && v <= math.MaxInt8:
+		return append(buf, byte(v))
+	case v >= 0 && v <= math.MaxUint8:
+		return append(buf, 0xcc, byte(v))
+	case v >= math.MinInt8 && v < 0:
+		return append(buf, 0xd0, byte(v))
+	case v >= 0 && v <= math.MaxUint16:
+		return binary.BigEndian.AppendUint16(append(buf, 0xcd), uint16(v))
+	case v >= math.MinInt16 && v < 0:
+		return binary.BigEndian.AppendUint16(append(buf, 0xd1), uint16(v))
+	case v >= 0 && v <= math.MaxUint32:
+		return binary.BigEndian.AppendUint32(append(buf, 0xce), uint32(v))
+	case v >= math.MinInt32 && v < 0:
+		return binary.BigEndian.AppendUint32(append(buf, 0xd2), uint32(v))
+	default:
+		return binary.BigEndian.AppendUint64(append(buf, 0xd3), uint64(v))
+	}
+}
+
+// msgpackReader decodes the MsgPack subset codecs need without building
+// objects, every method reports false on malformed or mismatching data.
+type msgpackReader struct {
+	data []byte
+	pos  int
+}
+
+func (r *msgpackReader) next(n int) (b []byte, ok bool) {
+	if n < 0 || len(r.data)-r.pos < n {
+		return
+	}
+	b = r.data[r.pos : r.pos+n]
+	r.pos += n
+	ok = true
+	return
+}
+
+func (r *msgpackReader) byte() (c byte, ok bool) {
+	b, ok := r.next(1)
+	if ok {
+		c = b[0]
+	}
+	return
+}
+
+// length reads a big endian length of 1, 2 or 4 bytes.
+func (r *msgpackReader) length(size int) (n int, ok bool) {
+	b, ok := r.next(size)
+	if !ok {
+		return
+	}
+	switch size {
+	case 1:
+		n = int(b[0])
+	case 2:
+		n = int(binary.BigEndian.Uint16(b))
+	case 4:
+		n = int(binary.BigEndian.Uint32(b))
+	}
+	return
+}
+
+func (r *msgpackReader) mapHeader() (n int, ok bool) {
+	c, ok := r.byte()
+	switch {
+	case !ok:
+	case c&0xf0 == 0x80:
+		n = int(c & 0x0f)
+	case c == 0xde:
+		n, ok = r.length(2)
+	case c == 0xdf:
+		n, ok = r.length(4)
+	default:
+		ok = false
+	}
+	return
+}
+
+// str reads a str or bin, nil reads as empty.
+func (r *msgpackReader) str() (s []byte, ok bool) {
+	c, ok := r.byte()
+	n := 0
+	switch {
+	case !ok:
+		return
+	case c&0xe0 == 0xa0:
+		n = int(c & 0x1f)
+	case c == 0xd9 || c == 0xc4:
+		n, ok = r.length(1)
+	case c == 0xda || c == 0xc5:
+		n, ok = r.length(2)
+	case c == 0xdb || c == 0xc6:
+		n, ok = r.length(4)
+	case c == 0xc0:
+		return
+	default:
+		ok = false
+	}
+	if ok {
+		s, ok = r.next(n)
+	}
+	return
+}
+
+func (r *msgpackReader) int() (v int64, ok bool) {
+	c, ok := r.byte()
+	if !ok {
+		return
+	}
+	if c <= 0x7f || c >= 0xe0 {
+		return int64(int8(c)), true
+	}
+	var b []byte
+	switch c {
+	case 0xcc, 0xd0:
+		b, ok = r.next(1)
+	case 0xcd, 0xd1:
+		b, ok = r.next(2)
+	case 0xce, 0xd2:
+		b, ok = r.next(4)
+	case 0xcf, 0xd3:
+		b, ok = r.next(8)
+	case 0xc0:
+		return
+	default:
+		ok = false
+	}
+	if !ok {
+		return
+	}
+	switch c {
+	case 0xcc:
+		v = int64(b[0])
+	case 0xd0:
+		v = int64(int8(b[0]))
+	case 0xcd:
+		v = int64(binary.BigEndian.Uint16(b))
+	case 0xd1:
+		v = int64(int16(binary.BigEndian.Uint16(b)))
+	case 0xce:
+		v = int64(binary.BigEndian.Uint32(b))
+	case 0xd2:
+		v = int64(int32(binary.BigEndian.Uint32(b)))
+	case 0xcf:
+		// A uint64 beyond the int64 range does not fit the field.
+		u := binary.BigEndian.Uint64(b)
+		v, ok = int64(u), u <= math.MaxInt64
+	case 0xd3:
+		v = int64(binary.BigEndian.Uint64(b))
+	}
+	return
+}
+
+// float reads a float, integers are converted.
+func (r *msgpackReader) float() (v float64, ok bool) {
+	start := r.pos
+	c, ok := r.byte()
+	if !ok {
+		return
+	}
+	switch c {
+	case 0xca:
+		var b []byte
+		if b, ok = r.next(4); ok {
+			v = float64(math.Float32frombits(binary.BigEndian.Uint32(b)))
+		}
+	case 0xcb:
+		var b []byte
+		if b, ok = r.next(8); ok {
+			v = math.Float64frombits(binary.BigEndian.Uint64(b))
+		}
+	case 0xcf:
+		var b []byte
+		if b, ok = r.next(8); ok {
+			v = float64(binary.BigEndian.Uint64(b))
+		}
+	default:
+		r.pos = start
+		var i int64
+		i, ok = r.int()
+		v = float64(i)
+	}
+	return
+}
+
+func (r *msgpackReader) bool() (v bool, ok bool) {
+	c, ok := r.byte()
+	switch {
+	case !ok:
+	case c == 0xc3:
+		v = true
+	case c == 0xc2 || c == 0xc0:
+	default:
+		ok = false
+	}
+	return
+}
+
+// skip skips one value of any type.
+func (r *msgpackReader) skip() (ok bool) {
+	c, ok := r.byte()
+	if !ok {
+		return
+	}
+	n, items := 0, 0
+	switch {
+	case c <= 0x7f || c >= 0xe0, c == 0xc0, c == 0xc2, c == 0xc3:
+		return true
+	case c&0xf0 == 0x80:
+		items = 2 * int(c&0x0f)
+	case c&0xf0 == 0x90:
+		items = int(c & 0x0f)
+	case c&0xe0 == 0xa0:
+		n = int(c & 0x1f)
+	case c == 0xcc, c == 0xd0, c == 0xd4:
+		n = 1
+	case c == 0xcd, c == 0xd1, c == 0xd5:
+		n = 2
+	case c == 0xce, c == 0xd2, c == 0xca:
+		n = 4
+	case c == 0xcf, c == 0xd3, c == 0xcb:
+		n = 8
+	case c == 0xd6:
+		n = 5
+	case c == 0xd7:
+		n = 9
+	case c == 0xd8:
+		n = 17
+	case c == 0xc4, c == 0xd9:
+		n, ok = r.length(1)
+	case c == 0xc5, c == 0xda:
+		n, ok = r.length(2)
+	case c == 0xc6, c == 0xdb:
+		n, ok = r.length(4)
+	case c == 0xc7:
+		n, ok = r.length(1)
+		n++
+	case c == 0xc8:
+		n, ok = r.length(2)
+		n++
+	case c == 0xc9:
+		n, ok = r.length(4)
+		n++
+	case c == 0xdc:
+		items, ok = r.length(2)
+	case c == 0xdd:
+		items, ok = r.length(4)
+	case c == 0xde:
+		items, ok = r.length(2)
+		items *= 2
+	case c == 0xdf:
+		items, ok = r.length(4)
+		items *= 2
+	default:
+		return false
+	}
+	if !ok {
+		return
+	}
+	if _, ok = r.next(n); !ok {
+		return
+	}
+	for ; items > 0 && ok; items-- {
+		ok = r.skip()
+	}
+	return
+}
+
+type codecRegister struct {
+	handles *handleTable
+}
+
+func (c *codecRegister) get(id C.int) (co *codec, err C.int) {
+	h, ok := c.handles.get(id)
+	if !ok {
+		err = ERR_INVALID_CODEC.asInt()
+		return
+	}
+	co = h.(*codec)
+	return
+}
+
+var codecs = codecRegister{
+	handles: newHandleTable(),
+}
+
+//export codec_new
+func codec_new(desc *C.char, function *C.char, list C.int, offsets *C.int, n C.int) C.int {
+	if n < 0 || (n > 0 && offsets == nil) {
+		return ERR_INVALID_CODEC.asInt()
+	}
+	c, err := newCodec(C.GoString(desc), C.GoString(function), list, unsafe.Slice(offsets, int(n)))
+	if err != NO_ERR.asInt() {
+		return err
+	}
+	return codecs.handles.add(c)
+}
+
+//export codec_remove
+func codec_remove(c C.int) C.int {
+	if _, ok := codecs.handles.remove(c); !ok {
+		return ERR_INVALID_CODEC.asInt()
+	}
+	return NO_ERR.asInt()
+}
+
+//export codec_pack
+func codec_pack(c C.int, src unsafe.Pointer, buf unsafe.Pointer, capacity C.int, size *C.int) C.int {
+	co, err := codecs.get(c)
+	if err != NO_ERR.asInt() {
+		return err
+	}
+	n, ok := co.size(src)
+	if !ok {
+		return ERR_MALFORMED_PARAMETERS.asInt()
+	}
+	*size = C.int(n)
+	if n > int(capacity) {
+		return ERR_BUFFER_TOO_SMALL.asInt()
+	}
+	co.pack(src, unsafe.Slice((*byte)(buf), n))
+	return NO_ERR.asInt()
+}
+
+//export codec_unpack
+func codec_unpack(c C.int, data unsafe.Pointer, size C.int, dst unsafe.Pointer) C.int {
+	co, err := codecs.get(c)
+	if err != NO_ERR.asInt() {
+		return err
+	}
+	if size < 0 || (size > 0 && data == nil) {
+		return ERR_MALFORMED_PARAMETERS.asInt()
+	}
+	return co.unpack(unsafe.Slice((*byte)(data), int(size)), dst)
+}
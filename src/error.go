@@ -37,6 +37,12 @@ const (
 	ERR_INVALID_FUNCTION
 	ERR_INVALID_PROPERTY
 	ERR_NO_UPDATE
+	ERR_NOT_SUPPORTED
+	ERR_BUFFER_TOO_SMALL
+	ERR_QUEUE_FULL
+	ERR_INVALID_QUEUE
+	ERR_INVALID_CODEC
+	ERR_MALFORMED_PARAMETERS
 )
 
 func (err tvio_err) String() (s string) {
@@ -63,6 +69,18 @@ func (err tvio_err) String() (s string) {
 		s = "Invalid Property"
 	case ERR_NO_UPDATE:
 		s = "No Property Update Available"
+	case ERR_NOT_SUPPORTED:
+		s = "Not Supported On This Platform"
+	case ERR_BUFFER_TOO_SMALL:
+		s = "Buffer Too Small"
+	case ERR_QUEUE_FULL:
+		s = "Queue Full"
+	case ERR_INVALID_QUEUE:
+		s = "Invalid Queue Or Policy"
+	case ERR_INVALID_CODEC:
+		s = "Invalid Codec"
+	case ERR_MALFORMED_PARAMETERS:
+		s = "Malformed Parameters"
 	}
 	return
 }
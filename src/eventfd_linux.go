@@ -0,0 +1,34 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+// #include <sys/eventfd.h>
+// #include <unistd.h>
+import "C"
+
+func newEventFD() C.int {
+	return C.eventfd(0, C.EFD_NONBLOCK|C.EFD_CLOEXEC)
+}
+
+func signalEventFD(fd C.int) {
+	C.eventfd_write(fd, 1)
+}
+
+func closeEventFD(fd C.int) {
+	C.close(fd)
+}
@@ -0,0 +1,254 @@
+//go:build bench
+
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+// C helpers of the benchmarks in export_bench_test.go, test files cannot use
+// cgo. Each loop runs in C and calls the library through the tvio_* wrappers
+// n times, so a benchmark pays one Go to C crossing and n crossings from C
+// into Go, the way a host calls the library.
+
+/*
+#cgo CFLAGS: -I${SRCDIR}/../include -DTVIO_NO_MAIN
+#include <stdlib.h>
+#include <string.h>
+#include "thingiverseio.h"
+
+static void bench_noop(void) {}
+
+static int bench_input_connected(int input, int n) {
+	int is, err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_input_connected(input, &is);
+	}
+	return err;
+}
+
+static int bench_output_connected(int output, int n) {
+	int is, err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_output_connected(output, &is);
+	}
+	return err;
+}
+
+static int bench_input_listen_result_available(int input, int n) {
+	int is, err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_input_listen_result_available(input, &is);
+	}
+	return err;
+}
+
+static int bench_input_change_available(int input, int n) {
+	int is, err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_input_change_available(input, &is);
+	}
+	return err;
+}
+
+static int bench_output_request_available(int output, int n) {
+	int is, err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_output_request_available(output, &is);
+	}
+	return err;
+}
+
+static int bench_input_stats(int input, int n) {
+	tvio_input_statistics *stats = malloc(sizeof(tvio_input_statistics));
+	int err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_input_stats(input, stats);
+	}
+	free(stats);
+	return err;
+}
+
+static int bench_output_stats(int output, int n) {
+	tvio_output_statistics *stats = malloc(sizeof(tvio_output_statistics));
+	int err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_output_stats(output, stats);
+	}
+	free(stats);
+	return err;
+}
+
+static int bench_poll(int input, int output, int n) {
+	tvio_poll_item items[2] = {{input, TVIO_POLL_INPUT, 0}, {output, TVIO_POLL_OUTPUT, 0}};
+	int ready, err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_poll(items, 2, 0, &ready);
+	}
+	return err;
+}
+
+static int bench_input_trigger(int input, char *function, void *params, int size, int n) {
+	int err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_input_trigger(input, function, params, size);
+	}
+	return err;
+}
+
+static int bench_output_emit(int output, char *function, void *params, int size, int n) {
+	int err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_output_emit(output, function, params, size, params, size);
+	}
+	return err;
+}
+
+static int bench_output_property_set(int output, char *property, void *value, int size, int n) {
+	int err = 0;
+	for (int k = 0; k < n; k++) {
+		err |= tvio_output_property_set(output, property, value, size);
+	}
+	return err;
+}
+
+// bench_call issues a CALL, serves it and collects the result, all on the
+// calling thread through the in-process path.
+static int bench_call(int input, int output, char *function, void *params, int size, void *buf, int n) {
+	for (int k = 0; k < n; k++) {
+		char *id, *req_id, *fn;
+		void *req_params;
+		int id_size, req_params_size, res_size, err;
+		if ((err = tvio_input_call(input, function, params, size, &id, &id_size)) != 0) {
+			return err;
+		}
+		if ((err = tvio_output_request_take(output, &req_id, &fn, &req_params, &req_params_size)) != 0) {
+			return err;
+		}
+		err = tvio_output_reply(output, req_id, req_params, req_params_size);
+		free(req_id);
+		if (err == 0) {
+			err = tvio_input_call_result_params_into(input, id, buf, size, &res_size);
+		}
+		free(id);
+		if (err != 0) {
+			return err;
+		}
+	}
+	return 0;
+}
+
+static long long bench_served;
+
+// bench_serve_handler stands in for a CPU heavy handler of tvio_output_serve,
+// it spins for a while and echoes the parameters.
+static void bench_serve_handler(int output, int worker, int function, void *params, int size, void **reply, int *reply_size, void *userdata) {
+	volatile unsigned x = 0;
+	for (int k = 0; k < 20000; k++) {
+		x += k;
+	}
+	*reply = malloc(size);
+	memcpy(*reply, params, size);
+	*reply_size = size;
+	__atomic_fetch_add(&bench_served, 1, __ATOMIC_RELAXED);
+}
+
+static void *bench_serve_handler_ptr(void) {
+	return bench_serve_handler;
+}
+
+static long long bench_served_load(void) {
+	return __atomic_load_n(&bench_served, __ATOMIC_RELAXED);
+}
+
+static void bench_served_reset(void) {
+	__atomic_store_n(&bench_served, 0, __ATOMIC_RELAXED);
+}
+*/
+import "C"
+
+import "unsafe"
+
+type cInt = C.int
+
+func cgoNoop() {
+	C.bench_noop()
+}
+
+func cString(s string) *C.char {
+	return C.CString(s)
+}
+
+func cBytes(p []byte) unsafe.Pointer {
+	return C.CBytes(p)
+}
+
+func cFree(p unsafe.Pointer) {
+	C.free(p)
+}
+
+// serveHandler returns bench_serve_handler and resets its counter.
+func serveHandler() unsafe.Pointer {
+	C.bench_served_reset()
+	return C.bench_serve_handler_ptr()
+}
+
+func served() int {
+	return int(C.bench_served_load())
+}
+
+// cgoLoops are the C loops by name, called with an input, an output, a
+// function or property name, the parameters and the number of iterations.
+var cgoLoops = map[string]func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int{
+	"input_connected": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_input_connected(i, n)
+	},
+	"output_connected": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_output_connected(o, n)
+	},
+	"input_listen_result_available": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_input_listen_result_available(i, n)
+	},
+	"input_change_available": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_input_change_available(i, n)
+	},
+	"output_request_available": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_output_request_available(o, n)
+	},
+	"input_stats": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_input_stats(i, n)
+	},
+	"output_stats": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_output_stats(o, n)
+	},
+	"poll": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_poll(i, o, n)
+	},
+	"input_trigger": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_input_trigger(i, name, params, size, n)
+	},
+	"output_emit": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_output_emit(o, name, params, size, n)
+	},
+	"output_property_set": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		return C.bench_output_property_set(o, name, params, size, n)
+	},
+	"call": func(i, o C.int, name *C.char, params unsafe.Pointer, size, n C.int) C.int {
+		buf := C.malloc(C.size_t(size) + 1)
+		defer C.free(buf)
+		return C.bench_call(i, o, name, params, size, buf, n)
+	},
+}
@@ -0,0 +1,256 @@
+//go:build bench
+
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import (
+	"fmt"
+	"runtime"
+	"testing"
+	"unsafe"
+
+	"github.com/ThingiverseIO/thingiverseio/core"
+	"github.com/ThingiverseIO/thingiverseio/descriptor"
+	"github.com/ThingiverseIO/thingiverseio/message"
+	"github.com/ThingiverseIO/uuid"
+	"github.com/joernweissenborn/eventual2go"
+)
+
+const benchDescriptor = "function Echo(Data string) (Data string)\n" +
+	"function Trigger(Data string) (Data string)\n" +
+	"property Value: Data string"
+
+var benchSizes = []int{16, 256, 4096, 65536, 1 << 20}
+
+// stubInputCore and stubOutputCore replace the cores, so the benchmarks
+// measure the binding without networking. Methods the binding does not use
+// in the benchmarks are left to the embedded nil interface.
+type stubInputCore struct {
+	core.InputCore
+	id     uuid.UUID
+	listen *message.ResultStreamController
+}
+
+func (c *stubInputCore) Connected() bool                     { return true }
+func (c *stubInputCore) Interface() string                   { return "bench" }
+func (c *stubInputCore) UUID() uuid.UUID                     { return c.id }
+func (c *stubInputCore) Shutdown()                           {}
+func (c *stubInputCore) Run()                                {}
+func (c *stubInputCore) Properties() []string                { return nil }
+func (c *stubInputCore) ListenStream() *message.ResultStream { return c.listen.Stream() }
+func (c *stubInputCore) StartListen(string) error            { return nil }
+func (c *stubInputCore) StopListen(string) error             { return nil }
+
+// Request accepts everything. CALLs normally take the in-process path, those
+// which do not get a future which never completes.
+func (c *stubInputCore) Request(string, message.CallType, []byte) (*message.ResultFuture, *message.ResultStream, uuid.UUID, error) {
+	return &message.ResultFuture{Future: eventual2go.NewCompleter().Future()}, nil, newUUID(), nil
+}
+
+type stubOutputCore struct {
+	core.OutputCore
+	id       uuid.UUID
+	requests *message.RequestStreamController
+}
+
+func (c *stubOutputCore) Connected() bool                       { return true }
+func (c *stubOutputCore) Interface() string                     { return "bench" }
+func (c *stubOutputCore) UUID() uuid.UUID                       { return c.id }
+func (c *stubOutputCore) Shutdown()                             {}
+func (c *stubOutputCore) Run()                                  {}
+func (c *stubOutputCore) RequestStream() *message.RequestStream { return c.requests.Stream() }
+func (c *stubOutputCore) Reply(*message.Request, []byte)        {}
+func (c *stubOutputCore) Emit(string, []byte, []byte) error     { return nil }
+func (c *stubOutputCore) SetProperty(string, []byte) error      { return nil }
+
+func init() {
+	newInputCore = func(descriptor.Descriptor) (core.InputCore, error) {
+		return &stubInputCore{id: newUUID(), listen: message.NewResultStreamController()}, nil
+	}
+	newOutputCore = func(descriptor.Descriptor) (core.OutputCore, error) {
+		return &stubOutputCore{id: newUUID(), requests: message.NewRequestStreamController()}, nil
+	}
+}
+
+// benchHandles creates an input and an output on the stubbed cores, which
+// find each other in-process.
+func benchHandles(b *testing.B) (i, o cInt) {
+	desc := cString(benchDescriptor)
+	defer cFree(unsafe.Pointer(desc))
+	if i = new_input(desc); i < 0 {
+		b.Fatalf("new_input: %d", i)
+	}
+	if o = new_output(desc); o < 0 {
+		b.Fatalf("new_output: %d", o)
+	}
+	b.Cleanup(func() {
+		input_remove(i)
+		output_remove(o)
+	})
+	return
+}
+
+// BenchmarkCgoNoop is the cost of a Go to C crossing, the baseline of the
+// other benchmarks.
+func BenchmarkCgoNoop(b *testing.B) {
+	for k := 0; k < b.N; k++ {
+		cgoNoop()
+	}
+}
+
+func BenchmarkRegisterGet(b *testing.B) {
+	i, o := benchHandles(b)
+	b.Run("input", func(b *testing.B) {
+		b.RunParallel(func(pb *testing.PB) {
+			for pb.Next() {
+				in, err := inputs.get(i)
+				if err != NO_ERR.asInt() {
+					b.Fatal(tvio_err(err))
+				}
+				in.release()
+			}
+		})
+	})
+	b.Run("output", func(b *testing.B) {
+		b.RunParallel(func(pb *testing.PB) {
+			for pb.Next() {
+				out, err := outputs.get(o)
+				if err != NO_ERR.asInt() {
+					b.Fatal(tvio_err(err))
+				}
+				out.release()
+			}
+		})
+	})
+}
+
+func BenchmarkGetParams(b *testing.B) {
+	for _, size := range benchSizes {
+		b.Run(fmt.Sprint(size), func(b *testing.B) {
+			p := cBytes(make([]byte, size))
+			defer cFree(p)
+			b.SetBytes(int64(size))
+			for k := 0; k < b.N; k++ {
+				getParams(p, cInt(size))
+			}
+		})
+	}
+}
+
+// BenchmarkCString and BenchmarkCBytes measure the marshalling of results
+// into C memory.
+func BenchmarkCString(b *testing.B) {
+	s := string(newUUID())
+	for k := 0; k < b.N; k++ {
+		cFree(unsafe.Pointer(cString(s)))
+	}
+}
+
+func BenchmarkCBytes(b *testing.B) {
+	for _, size := range benchSizes {
+		b.Run(fmt.Sprint(size), func(b *testing.B) {
+			p := make([]byte, size)
+			b.SetBytes(int64(size))
+			for k := 0; k < b.N; k++ {
+				cFree(cBytes(p))
+			}
+		})
+	}
+}
+
+// BenchmarkExport calls exported functions from C through the tvio_*
+// wrappers. Functions taking parameters run for every size.
+//
+// Not every export has a loop. The ones below stand for the kinds of
+// crossing hosts make: a handle lookup returning a flag, filling a struct,
+// tvio_poll, sending parameters one way and a full CALL round trip. Other
+// exports of the same kind cost about the same; add a loop in
+// export_bench.go to measure one of them on its own.
+func BenchmarkExport(b *testing.B) {
+	i, o := benchHandles(b)
+	names := map[string]string{
+		"input_trigger":       "Trigger",
+		"output_emit":         "Echo",
+		"output_property_set": "Value",
+		"call":                "Echo",
+	}
+	for _, export := range []string{
+		"input_connected",
+		"output_connected",
+		"input_listen_result_available",
+		"input_change_available",
+		"output_request_available",
+		"input_stats",
+		"output_stats",
+		"poll",
+		"input_trigger",
+		"output_emit",
+		"output_property_set",
+		"call",
+	} {
+		loop := cgoLoops[export]
+		name, sized := names[export]
+		if !sized {
+			b.Run(export, func(b *testing.B) {
+				if err := loop(i, o, nil, nil, 0, cInt(b.N)); err != 0 {
+					b.Fatal(tvio_err(err))
+				}
+			})
+			continue
+		}
+		cname := cString(name)
+		for _, size := range benchSizes {
+			b.Run(fmt.Sprintf("%s/%d", export, size), func(b *testing.B) {
+				p := cBytes(make([]byte, size))
+				defer cFree(p)
+				b.SetBytes(int64(size))
+				if err := loop(i, o, cname, p, cInt(size), cInt(b.N)); err != 0 {
+					b.Fatal(tvio_err(err))
+				}
+			})
+		}
+		cFree(unsafe.Pointer(cname))
+	}
+}
+
+// BenchmarkServe dispatches requests to the serve workers of an output. The
+// handler spins, so the throughput should scale with the workers.
+func BenchmarkServe(b *testing.B) {
+	_, o := benchHandles(b)
+	out, err := outputs.get(o)
+	if err != NO_ERR.asInt() {
+		b.Fatal(tvio_err(err))
+	}
+	defer out.release()
+	params := make([]byte, 64)
+	for _, workers := range []int{1, 2, 4, 8} {
+		b.Run(fmt.Sprint(workers), func(b *testing.B) {
+			if err := output_serve(o, cInt(workers), serveHandler(), nil); err != 0 {
+				b.Fatal(tvio_err(err))
+			}
+			defer output_serve(o, 0, nil, nil)
+			for k := 0; k < b.N; k++ {
+				out.dispatch(&request{UUID: newUUID(), Function: "Echo", params: params})
+			}
+			for served() < b.N {
+				runtime.Gosched()
+			}
+		})
+	}
+}
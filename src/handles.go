@@ -0,0 +1,112 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import "C"
+
+import (
+	"sync"
+	"sync/atomic"
+)
+
+// handle is embedded into inputs and outputs. It counts the references held
+// by the table and by running calls, so a removed handle is only shut down
+// after the last call using it has returned.
+type handle struct {
+	refs     int32
+	shutdown func()
+}
+
+func newHandle(shutdown func()) handle {
+	return handle{
+		refs:     1,
+		shutdown: shutdown,
+	}
+}
+
+// acquire takes a reference, it fails if the handle was already removed.
+func (h *handle) acquire() bool {
+	for {
+		n := atomic.LoadInt32(&h.refs)
+		if n == 0 {
+			return false
+		}
+		if atomic.CompareAndSwapInt32(&h.refs, n, n+1) {
+			return true
+		}
+	}
+}
+
+func (h *handle) release() {
+	if atomic.AddInt32(&h.refs, -1) == 0 {
+		h.shutdown()
+	}
+}
+
+// handleTable maps references to handles. Lookups read an immutable snapshot
+// of the map and never block, while additions and removals copy it.
+type handleTable struct {
+	m       *sync.Mutex
+	n       C.int
+	handles atomic.Value
+}
+
+func newHandleTable() *handleTable {
+	t := &handleTable{
+		m: &sync.Mutex{},
+	}
+	t.handles.Store(map[C.int]interface{}{})
+	return t
+}
+
+func (t *handleTable) get(id C.int) (h interface{}, ok bool) {
+	h, ok = t.handles.Load().(map[C.int]interface{})[id]
+	return
+}
+
+func (t *handleTable) add(h interface{}) (id C.int) {
+	t.m.Lock()
+	defer t.m.Unlock()
+	old := t.handles.Load().(map[C.int]interface{})
+	handles := make(map[C.int]interface{}, len(old)+1)
+	for k, v := range old {
+		handles[k] = v
+	}
+	id = t.n
+	t.n++
+	handles[id] = h
+	t.handles.Store(handles)
+	return
+}
+
+func (t *handleTable) remove(id C.int) (h interface{}, ok bool) {
+	t.m.Lock()
+	defer t.m.Unlock()
+	old := t.handles.Load().(map[C.int]interface{})
+	if h, ok = old[id]; !ok {
+		return
+	}
+	handles := make(map[C.int]interface{}, len(old))
+	for k, v := range old {
+		if k != id {
+			handles[k] = v
+		}
+	}
+	t.handles.Store(handles)
+	return
+}
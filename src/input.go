@@ -21,6 +21,8 @@ import "C"
 
 import (
 	"sync"
+	"sync/atomic"
+	"time"
 	"unsafe"
 
 	"github.com/ThingiverseIO/thingiverseio/config"
@@ -36,137 +38,449 @@ type propertyChange struct {
 	value []byte
 }
 
-func toPropertyChange(name string) eventual2go.Transformer {
-	return func(d eventual2go.Data) eventual2go.Data {
-		return propertyChange{
-			name:  name,
-			value: d.([]byte),
-		}
+// coalescedChange is the pending change of a property observed in coalesced
+// mode. It is queued at most once, further changes replace its value until the
+// host retrieves it.
+type coalescedChange struct {
+	m      *sync.Mutex
+	name   string
+	value  []byte
+	queued bool
+	fresh  bool
+}
+
+func (c *coalescedChange) update(value []byte, changes *queue) {
+	c.m.Lock()
+	c.value = value
+	c.fresh = true
+	queued := c.queued
+	c.queued = true
+	c.m.Unlock()
+	if !queued && !changes.add(c) {
+		c.drop()
+	}
+}
+
+// peek returns the current value and marks it as seen.
+func (c *coalescedChange) peek() propertyChange {
+	c.m.Lock()
+	defer c.m.Unlock()
+	c.fresh = false
+	return propertyChange{name: c.name, value: c.value}
+}
+
+// take returns the current value and unqueues the change.
+func (c *coalescedChange) take() propertyChange {
+	c.m.Lock()
+	defer c.m.Unlock()
+	c.fresh = false
+	c.queued = false
+	return propertyChange{name: c.name, value: c.value}
+}
+
+// clear unqueues the change, unless it was updated since it was last seen. In
+// that case it returns true and the change has to be queued again.
+func (c *coalescedChange) clear() (requeue bool) {
+	c.m.Lock()
+	defer c.m.Unlock()
+	if c.fresh {
+		return true
+	}
+	c.queued = false
+	return false
+}
+
+// drop unqueues the change once the queue dropped or refused it.
+func (c *coalescedChange) drop() {
+	c.m.Lock()
+	defer c.m.Unlock()
+	c.queued = false
+}
+
+func peekChange(d interface{}) propertyChange {
+	if c, ok := d.(*coalescedChange); ok {
+		return c.peek()
+	}
+	return d.(propertyChange)
+}
+
+func takeChange(d interface{}) propertyChange {
+	if c, ok := d.(*coalescedChange); ok {
+		return c.take()
+	}
+	return d.(propertyChange)
+}
+
+// callAll buffers the results of a CALL-ALL request until it is cleared.
+type callAll struct {
+	results *queue
+	stop    *eventual2go.Completer
+}
+
+// pendingResult is the result of a CALL. It is completed either by the core
+// or directly by an output in the same process, or fails if the output goes
+// away first. Only the first completion or failure counts.
+type pendingResult struct {
+	key      requestID
+	in       *input
+	shm      *shmConn
+	start    time.Time
+	done     chan struct{}
+	finished int32
+	params   []byte
+	err      C.int
+}
+
+func (r *pendingResult) complete(params []byte) {
+	if !atomic.CompareAndSwapInt32(&r.finished, 0, 1) {
+		return
+	}
+	r.in.stats.received(params)
+	r.in.stats.callTime.record(time.Since(r.start))
+	r.finish(params, NO_ERR.asInt())
+}
+
+// fail completes the result with an error, which is returned when the
+// result is retrieved.
+func (r *pendingResult) fail(err C.int) {
+	if !atomic.CompareAndSwapInt32(&r.finished, 0, 1) {
+		return
+	}
+	r.finish(nil, err)
+}
+
+func (r *pendingResult) finish(params []byte, err C.int) {
+	r.params = params
+	r.err = err
+	close(r.done)
+	atomic.AddInt32(&r.in.resultsReady, 1)
+	r.in.m.RLock()
+	completions := r.in.completions
+	r.in.m.RUnlock()
+	if completions != nil {
+		completions.add(r.key)
+		return
+	}
+	r.in.s.notify()
+}
+
+func (r *pendingResult) completed() bool {
+	select {
+	case <-r.done:
+		return true
+	default:
+		return false
 	}
 }
 
 type input struct {
+	handle
+	iface           string
+	names           *names
 	m               *sync.RWMutex
 	c               core.InputCore
-	results         map[uuid.UUID]*message.ResultFuture
-	callall         map[uuid.UUID]*message.ResultCollector
-	listen          *message.ResultCollector
-	propertyChanges *eventual2go.Collector
+	s               *signal
+	results         map[requestID]*pendingResult
+	resultsReady    int32
+	stats           *inputStats
+	completions     *queue
+	shm             *shmClient
+	callall         map[requestID]*callAll
+	listen          *queue
+	propertyChanges *queue
+	observed        map[string]bool
+	coalesced       map[string]*coalescedChange
+	mirrors         map[string]*propertyMirror
 	propertyUpdates map[string]*eventual2go.Future
 }
 
+// newInputCore creates the core behind an input. The Go benchmarks replace it
+// to measure the binding without networking.
+var newInputCore = func(d descriptor.Descriptor) (core.InputCore, error) {
+	cfg := config.Configure()
+	tracker, provider := core.DefaultBackends()
+	return core.NewInputCore(d, cfg, tracker, provider...)
+}
+
 func newInput(desc string) (i *input, err C.int) {
 	d, derr := descriptor.Parse(desc)
 	if derr != nil {
 		err = ERR_INVALID_DESCRIPTOR.asInt()
 		return
 	}
-	cfg := config.Configure()
-	tracker, provider := core.DefaultBackends()
-	c, nerr := core.NewInputCore(d, cfg, tracker, provider...)
+	c, nerr := newInputCore(d)
 	if nerr != nil {
 		err = ERR_NETWORK.asInt()
 		return
 	}
+	s := newSignal()
 	i = &input{
+		handle:          newHandle(c.Shutdown),
+		iface:           c.Interface(),
+		names:           newNames(d),
 		m:               &sync.RWMutex{},
 		c:               c,
-		results:         map[uuid.UUID]*message.ResultFuture{},
-		callall:         map[uuid.UUID]*message.ResultCollector{},
-		listen:          message.NewResultCollector(),
-		propertyChanges: eventual2go.NewCollector(),
+		s:               s,
+		results:         map[requestID]*pendingResult{},
+		callall:         map[requestID]*callAll{},
+		listen:          newQueue(s),
+		propertyChanges: newQueue(s),
+		observed:        map[string]bool{},
+		coalesced:       map[string]*coalescedChange{},
+		mirrors:         map[string]*propertyMirror{},
+		stats:           &inputStats{},
 		propertyUpdates: map[string]*eventual2go.Future{},
 	}
 	for _, p := range c.Properties() {
 		o, _ := c.GetProperty(p)
-		i.propertyChanges.AddStream(o.Stream().Transform(toPropertyChange(p)))
+		o.Stream().Listen(i.onPropertyChange(p))
 	}
-	i.listen.AddStream(c.ListenStream())
+	c.ListenStream().Listen(func(r *message.Result) {
+		i.stats.received(r.Parameter())
+		i.listen.add(r)
+	})
+	i.shm = newShmClient(i.iface, c.UUID(), i.completeResult, i.failResult, i.failShm)
 	i.c.Run()
 	return
 }
 
-type inputRegister struct {
-	n        int
-	m        *sync.RWMutex
-	register map[C.int]*input
+// onPropertyChange updates the mirror of a property and queues its changes,
+// or coalesces them if the property is observed in coalesced mode. Changes
+// of properties which are only observed for their mirror are not queued.
+func (in *input) onPropertyChange(name string) eventual2go.Subscriber {
+	return func(d eventual2go.Data) {
+		in.m.RLock()
+		observed := in.observed[name]
+		c := in.coalesced[name]
+		m := in.mirrors[name]
+		in.m.RUnlock()
+		if m != nil {
+			m.store(d.([]byte))
+		}
+		if !observed {
+			return
+		}
+		if c != nil {
+			c.update(d.([]byte), in.propertyChanges)
+			return
+		}
+		in.propertyChanges.add(propertyChange{
+			name:  name,
+			value: d.([]byte),
+		})
+	}
+}
+
+// awaitResult completes a pending result once the core has received it.
+func (in *input) awaitResult(res *message.ResultFuture, r *pendingResult) {
+	res.Then(func(m *message.Result) *message.Result {
+		r.complete(m.Parameter())
+		return m
+	})
+}
+
+// completeResult completes a result which arrived through the shared memory
+// transport.
+func (in *input) completeResult(resID uuid.UUID, params []byte) {
+	in.m.RLock()
+	r, ok := in.results[requestKey(resID)]
+	in.m.RUnlock()
+	if ok {
+		r.complete(params)
+	}
 }
 
-func (i *inputRegister) next() (n int) {
-	n = i.n
-	i.n++
+// failResult fails a CALL which the output refused over the shared memory
+// transport.
+func (in *input) failResult(resID uuid.UUID, code int32) {
+	in.m.RLock()
+	r, ok := in.results[requestKey(resID)]
+	in.m.RUnlock()
+	if ok {
+		r.fail(C.int(code))
+	}
+}
+
+// failShm fails the CALLs which were sent over a shared memory connection
+// which is gone, e.g. because the output process died.
+func (in *input) failShm(c *shmConn) {
+	var lost []*pendingResult
+	in.m.RLock()
+	for _, r := range in.results {
+		if r.shm == c {
+			lost = append(lost, r)
+		}
+	}
+	in.m.RUnlock()
+	for _, r := range lost {
+		r.fail(ERR_NETWORK.asInt())
+	}
+}
+
+// request issues a CALL. If an output with the same interface lives in this
+// process, the request is handed to it directly and never touches the
+// network. Outputs in other processes on this host are reached through the
+// shared memory transport if it is enabled.
+func (in *input) request(function string, params []byte) (resID uuid.UUID, err C.int) {
+	start := time.Now()
+	if out := locals.output(in.iface); out != nil && in.names.hasFunction(function) && out.acquire() {
+		resID = newUUID()
+		r := in.pending(resID, start, nil)
+		ok := out.dispatch(&request{
+			UUID:     resID,
+			Function: function,
+			params:   params,
+			local:    r,
+		})
+		removed := out.removed()
+		out.release()
+		if ok {
+			in.stats.sent(params)
+			return
+		}
+		in.m.Lock()
+		delete(in.results, r.key)
+		in.m.Unlock()
+		if !removed {
+			err = ERR_QUEUE_FULL.asInt()
+			return
+		}
+		// The output was removed meanwhile, try the other transports.
+	}
+	if c := in.shm.conn(); c != nil && in.names.hasFunction(function) {
+		resID = newUUID()
+		r := in.pending(resID, start, c)
+		if c.send(resID, function, params) {
+			in.stats.sent(params)
+			return
+		}
+		in.m.Lock()
+		delete(in.results, r.key)
+		in.m.Unlock()
+	}
+	res, _, resID, ferr := in.c.Request(function, message.CALL, params)
+	if ferr != nil {
+		err = ERR_INVALID_FUNCTION.asInt()
+		return
+	}
+	in.stats.sent(params)
+	in.awaitResult(res, in.pending(resID, start, nil))
 	return
 }
 
+// pending registers the result of a CALL issued at start, c is the shared
+// memory connection it is sent over, if any.
+func (in *input) pending(resID uuid.UUID, start time.Time, c *shmConn) *pendingResult {
+	r := &pendingResult{
+		key:   requestKey(resID),
+		in:    in,
+		shm:   c,
+		start: start,
+		done:  make(chan struct{}),
+	}
+	in.m.Lock()
+	defer in.m.Unlock()
+	in.results[r.key] = r
+	return r
+}
+
+type inputRegister struct {
+	handles *handleTable
+}
+
 func (i *inputRegister) new(desc string) (idOrErr C.int) {
-	i.m.Lock()
-	defer i.m.Unlock()
 	in, idOrErr := newInput(desc)
 	if idOrErr != NO_ERR.asInt() {
 		return
 	}
-	idOrErr = C.int(i.next())
-	i.register[idOrErr] = in
+	idOrErr = i.handles.add(in)
+	locals.addInput(in.iface)
 	return
 }
 
-func (i *inputRegister) connected(id C.int) (is bool, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
+// get looks up an input and takes a reference, which must be released.
+func (i *inputRegister) get(id C.int) (in *input, err C.int) {
+	h, ok := i.handles.get(id)
 	if !ok {
 		err = ERR_INVALID_INPUT.asInt()
 		return
 	}
-	is = in.c.Connected()
+	in = h.(*input)
+	if !in.acquire() {
+		err = ERR_INVALID_INPUT.asInt()
+	}
+	return
+}
+
+func (i *inputRegister) connected(id C.int) (is bool, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	is = in.c.Connected() || locals.output(in.iface) != nil
 	return
 }
 
 func (i *inputRegister) iface(id C.int) (iface string, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	iface = in.c.Interface()
 	return
 }
 
 func (i *inputRegister) uuid(id C.int) (iID uuid.UUID, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	iID = in.c.UUID()
 	return
 }
 
 func (i *inputRegister) remove(id C.int) (err C.int) {
-	i.m.Lock()
-	defer i.m.Unlock()
-	in, ok := i.register[id]
-	if !ok {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	if _, ok := i.handles.remove(id); !ok {
 		err = ERR_INVALID_INPUT.asInt()
 		return
 	}
-	in.c.Shutdown()
-	delete(i.register, id)
+	locals.removeInput(in.iface)
+	in.shm.close()
+	in.m.Lock()
+	for _, m := range in.mirrors {
+		m.free()
+	}
+	in.mirrors = map[string]*propertyMirror{}
+	pending := make([]*pendingResult, 0, len(in.results))
+	for _, r := range in.results {
+		pending = append(pending, r)
+	}
+	in.m.Unlock()
+	// Results arriving later are dropped, hosts still waiting are woken.
+	for _, r := range pending {
+		r.fail(ERR_INVALID_INPUT.asInt())
+	}
+	in.listen.close()
+	in.propertyChanges.close()
+	in.s.close()
+	in.release()
 	return
 }
 
 func (i *inputRegister) startListen(id C.int, function string) (err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	ferr := in.c.StartListen(function)
 	if ferr != nil {
 		err = ERR_INVALID_FUNCTION.asInt()
@@ -175,13 +489,11 @@ func (i *inputRegister) startListen(id C.int, function string) (err C.int) {
 }
 
 func (i *inputRegister) stopListen(id C.int, function string) (err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	ferr := in.c.StopListen(function)
 	if ferr != nil {
 		err = ERR_INVALID_FUNCTION.asInt()
@@ -189,109 +501,146 @@ func (i *inputRegister) stopListen(id C.int, function string) (err C.int) {
 	return
 }
 
-func (i *inputRegister) startObserve(id C.int, property string) (err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+// startObserve observes a property. In coalesced mode only the newest
+// change of the property is kept until the host retrieves it.
+func (i *inputRegister) startObserve(id C.int, property string, coalesced bool) (err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
-	ferr := in.c.StartObservation(property)
-	if ferr != nil {
+	defer in.release()
+	if _, ferr := in.c.GetProperty(property); ferr != nil {
+		err = ERR_INVALID_PROPERTY.asInt()
+		return
+	}
+	// The current value, which the core sends right away, has to be queued.
+	in.m.Lock()
+	in.observed[property] = true
+	if !coalesced {
+		delete(in.coalesced, property)
+	} else if in.coalesced[property] == nil {
+		in.coalesced[property] = &coalescedChange{
+			m:    &sync.Mutex{},
+			name: property,
+		}
+	}
+	in.m.Unlock()
+	if in.c.StartObservation(property) != nil {
 		err = ERR_INVALID_PROPERTY.asInt()
 	}
 	return
 }
 
 func (i *inputRegister) stopObserve(id C.int, property string) (err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
-	ferr := in.c.StopObservation(property)
-	if ferr != nil {
+	defer in.release()
+	if _, ferr := in.c.GetProperty(property); ferr != nil {
+		err = ERR_INVALID_PROPERTY.asInt()
+		return
+	}
+	in.m.Lock()
+	delete(in.observed, property)
+	delete(in.coalesced, property)
+	mirrored := in.mirrors[property] != nil
+	in.m.Unlock()
+	// A mirror keeps the property observed.
+	if !mirrored && in.c.StopObservation(property) != nil {
 		err = ERR_INVALID_PROPERTY.asInt()
 	}
 	return
 }
 
 func (i *inputRegister) propertyChanged(id C.int) (is bool, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
-	in.m.Lock()
-	defer in.m.Unlock()
-	is = !in.propertyChanges.Empty()
+	defer in.release()
+	is = !in.propertyChanges.empty()
+	return
+}
+
+func (i *inputRegister) waitPropertyChanged(id C.int, timeout C.int) (is bool, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	is = in.s.wait(timeout, func() bool { return !in.propertyChanges.empty() })
 	return
 }
 
 func (i *inputRegister) nextChangeProperty(id C.int) (property string, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
-	in.m.Lock()
-	defer in.m.Unlock()
-	if in.propertyChanges.Empty() {
+	defer in.release()
+	c, ok := in.propertyChanges.preview()
+	if !ok {
 		err = ERR_NO_UPDATE.asInt()
+		return
 	}
-	property = in.propertyChanges.Preview().(propertyChange).name
+	property = peekChange(c).name
 	return
 }
 
 func (i *inputRegister) nextChangeValue(id C.int) (value []byte, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
-	in.m.Lock()
-	defer in.m.Unlock()
-	if in.propertyChanges.Empty() {
+	defer in.release()
+	c, ok := in.propertyChanges.preview()
+	if !ok {
 		err = ERR_NO_UPDATE.asInt()
+		return
 	}
-	value = in.propertyChanges.Preview().(propertyChange).value
+	value = peekChange(c).value
 	return
 }
 
 func (i *inputRegister) clearNextChange(id C.int) (err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	c, ok := in.propertyChanges.get()
 	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+		err = ERR_NO_UPDATE.asInt()
 		return
 	}
-	in.m.Lock()
-	defer in.m.Unlock()
-	if in.propertyChanges.Empty() {
+	if cc, ok := c.(*coalescedChange); ok && cc.clear() && !in.propertyChanges.add(cc) {
+		cc.drop()
+	}
+	return
+}
+
+func (i *inputRegister) takeChange(id C.int) (change propertyChange, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	c, ok := in.propertyChanges.get()
+	if !ok {
 		err = ERR_NO_UPDATE.asInt()
+		return
 	}
-	in.propertyChanges.Get()
+	change = takeChange(c)
 	return
 }
 
 func (i *inputRegister) updateProperty(id C.int, property string) (err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	in.m.Lock()
 	defer in.m.Unlock()
 	if f, ok := in.propertyUpdates[property]; ok {
@@ -308,13 +657,11 @@ func (i *inputRegister) updateProperty(id C.int, property string) (err C.int) {
 }
 
 func (i *inputRegister) propertyUpdateAvailable(id C.int, property string) (is bool, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 
 	in.m.RLock()
 	defer in.m.RUnlock()
@@ -326,14 +673,15 @@ func (i *inputRegister) propertyUpdateAvailable(id C.int, property string) (is b
 	return
 }
 
-func (i *inputRegister) getPropertyUpdate(id C.int, property string) (value []byte, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+// getPropertyUpdate retrieves and clears a property update. If the value is
+// larger than max, the update is kept and ERR_BUFFER_TOO_SMALL is returned. A
+// negative max means no limit.
+func (i *inputRegister) getPropertyUpdate(id C.int, property string, max int) (value []byte, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	in.m.Lock()
 	defer in.m.Unlock()
 	p, is := in.propertyUpdates[property]
@@ -346,107 +694,251 @@ func (i *inputRegister) getPropertyUpdate(id C.int, property string) (value []by
 		return
 	}
 	value = p.Result().([]byte)
+	if max >= 0 && len(value) > max {
+		err = ERR_BUFFER_TOO_SMALL.asInt()
+		return
+	}
 	delete(in.propertyUpdates, property)
 	return
 }
 
 func (i *inputRegister) getProperty(id C.int, property string) (value []byte, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	value, err = in.getProperty(property)
+	return
+}
+
+func (i *inputRegister) getPropertyByID(id C.int, propertyID C.int) (value []byte, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
+	property, err := in.names.property(propertyID)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	value, err = in.getProperty(property)
+	return
+}
+
+func (in *input) getProperty(property string) (value []byte, err C.int) {
 	p, ferr := in.c.GetProperty(property)
 	if ferr != nil {
 		err = ERR_INVALID_PROPERTY.asInt()
+		return
 	}
 	value = p.Value().([]byte)
 	return
 }
 
-func (i *inputRegister) call(id C.int, function string, params []byte) (resID uuid.UUID, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+func (i *inputRegister) functionID(id C.int, function string) (functionID C.int, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
-	res, _, resID, ferr := in.c.Request(function, message.CALL, params)
+	defer in.release()
+	functionID, err = in.names.functionID(function)
+	return
+}
+
+func (i *inputRegister) propertyID(id C.int, property string) (propertyID C.int, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	propertyID, err = in.names.propertyID(property)
+	return
+}
+
+// mirrorProperty returns the mirror of a property, creating it with the given
+// capacity if it does not exist yet.
+func (i *inputRegister) mirrorProperty(id C.int, property string, capacity int) (mirror unsafe.Pointer, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	p, ferr := in.c.GetProperty(property)
 	if ferr != nil {
-		err = ERR_INVALID_FUNCTION.asInt()
+		err = ERR_INVALID_PROPERTY.asInt()
 		return
 	}
 	in.m.Lock()
-	defer in.m.Unlock()
-	in.results[resID] = res
+	m, mapped := in.mirrors[property]
+	if !mapped {
+		m = newPropertyMirror(capacity)
+		in.mirrors[property] = m
+	}
+	in.m.Unlock()
+	if mapped && m.capacity() < capacity {
+		err = ERR_BUFFER_TOO_SMALL.asInt()
+		return
+	}
+	if v, ok := p.Value().([]byte); ok {
+		m.storeInitial(v)
+	}
+	if !mapped && in.c.StartObservation(property) != nil {
+		in.m.Lock()
+		delete(in.mirrors, property)
+		in.m.Unlock()
+		m.free()
+		err = ERR_INVALID_PROPERTY.asInt()
+		return
+	}
+	mirror = m.pointer()
+	return
+}
+
+func (i *inputRegister) call(id C.int, function string, params []byte) (resID uuid.UUID, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	resID, err = in.request(function, params)
+	return
+}
+
+func (i *inputRegister) callByID(id C.int, functionID C.int, params []byte) (resID uuid.UUID, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	function, err := in.names.function(functionID)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	resID, err = in.request(function, params)
 	return
 }
 
 func (i *inputRegister) callAll(id C.int, function string, params []byte) (resID uuid.UUID, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	_, res, resID, ferr := in.c.Request(function, message.CALLALL, params)
 	if ferr != nil {
 		err = ERR_INVALID_FUNCTION.asInt()
 		return
 	}
+	in.stats.sent(params)
+	ca := &callAll{
+		results: newQueue(in.s),
+		stop:    eventual2go.NewCompleter(),
+	}
+	res.Listen(func(r *message.Result) {
+		in.stats.received(r.Parameter())
+		ca.results.add(r)
+	})
+	res.CloseOnFuture(ca.stop.Future())
 	in.m.Lock()
 	defer in.m.Unlock()
-	in.callall[resID] = message.NewResultCollector()
-	in.callall[resID].AddStream(res)
-	res.CloseOnFuture(in.callall[resID].Stopped())
+	in.callall[requestKey(resID)] = ca
 	return
 }
 
 func (i *inputRegister) trigger(id C.int, function string, params []byte) (err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
+	err = in.trigger(function, params)
+	return
+}
+
+func (i *inputRegister) triggerByID(id C.int, functionID C.int, params []byte) (err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	function, err := in.names.function(functionID)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	err = in.trigger(function, params)
+	return
+}
+
+func (in *input) trigger(function string, params []byte) (err C.int) {
 	_, _, _, ferr := in.c.Request(function, message.TRIGGER, params)
 	if ferr != nil {
 		err = ERR_INVALID_FUNCTION.asInt()
 		return
 	}
+	in.stats.sent(params)
 	return
 }
 
 func (i *inputRegister) triggerAll(id C.int, function string, params []byte) (err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	_, _, _, ferr := in.c.Request(function, message.TRIGGERALL, params)
 	if ferr != nil {
 		err = ERR_INVALID_FUNCTION.asInt()
 		return
 	}
+	in.stats.sent(params)
 	return
 }
 
-func (i *inputRegister) resultReady(id C.int, resID uuid.UUID) (ready bool, err C.int) {
+// callBatch issues CALLs in order until one fails. It returns the ids of the
+// issued CALLs, so the failed one is at index len(resIDs).
+func (i *inputRegister) callBatch(id C.int, functions []string, params [][]byte) (resIDs []uuid.UUID, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	resIDs = make([]uuid.UUID, 0, len(functions))
+	for n, function := range functions {
+		resID, ferr := in.request(function, params[n])
+		if ferr != NO_ERR.asInt() {
+			err = ferr
+			return
+		}
+		resIDs = append(resIDs, resID)
+	}
+	return
+}
 
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+// triggerBatch issues TRIGGERs in order until one fails and returns how many
+// were issued.
+func (i *inputRegister) triggerBatch(id C.int, functions []string, params [][]byte) (issued int, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
+	for n, function := range functions {
+		if err = in.trigger(function, params[n]); err != NO_ERR.asInt() {
+			return
+		}
+		issued++
+	}
+	return
+}
+
+func (i *inputRegister) resultReady(id C.int, resID requestID) (ready bool, err C.int) {
+
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
 
 	in.m.RLock()
 	defer in.m.RUnlock()
@@ -455,20 +947,39 @@ func (i *inputRegister) resultReady(id C.int, resID uuid.UUID) (ready bool, err
 		err = ERR_INVALID_RESULT_ID.asInt()
 		return
 	}
-	ready = req.Completed()
+	ready = req.completed()
 	return
 
 }
 
-func (i *inputRegister) resultParameter(id C.int, resID uuid.UUID) (params []byte, err C.int) {
+func (i *inputRegister) waitResult(id C.int, resID requestID, timeout C.int) (ready bool, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
 
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
+	in.m.RLock()
+	req, ok := in.results[resID]
+	in.m.RUnlock()
 	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+		err = ERR_INVALID_RESULT_ID.asInt()
+		return
+	}
+	ready = in.s.wait(timeout, req.completed)
+	return
+}
+
+// resultParameter retrieves and clears a result. If the parameters are larger
+// than max, the result is kept and ERR_BUFFER_TOO_SMALL is returned. A negative
+// max means no limit. A failed CALL is cleared and returns its error.
+func (i *inputRegister) resultParameter(id C.int, resID requestID, max int) (params []byte, err C.int) {
+
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 
 	in.m.Lock()
 	defer in.m.Unlock()
@@ -477,208 +988,391 @@ func (i *inputRegister) resultParameter(id C.int, resID uuid.UUID) (params []byt
 		err = ERR_INVALID_RESULT_ID.asInt()
 		return
 	}
-	if !req.Completed() {
+	if !req.completed() {
 		err = ERR_RESULT_NOT_ARRIVED.asInt()
 		return
 	}
-	params = req.Result().Parameter()
+	if req.err != NO_ERR.asInt() {
+		err = req.err
+		delete(in.results, resID)
+		atomic.AddInt32(&in.resultsReady, -1)
+		return
+	}
+	params = req.params
+	if max >= 0 && len(params) > max {
+		err = ERR_BUFFER_TOO_SMALL.asInt()
+		return
+	}
 	delete(in.results, resID)
+	atomic.AddInt32(&in.resultsReady, -1)
+	return
+
+}
+
+// startCompletions enables the completion queue. Every CALL result which
+// completes afterwards is queued until it is taken.
+func (i *inputRegister) startCompletions(id C.int) (err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	in.m.Lock()
+	defer in.m.Unlock()
+	if in.completions == nil {
+		in.completions = newQueue(in.s)
+	}
 	return
+}
 
+func (i *inputRegister) waitCompletions(id C.int, timeout C.int) (is bool, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	in.m.RLock()
+	completions := in.completions
+	in.m.RUnlock()
+	if completions == nil {
+		err = ERR_NOT_SUPPORTED.asInt()
+		return
+	}
+	is = in.s.wait(timeout, func() bool { return !completions.empty() })
+	return
+}
+
+// takeCompletions retrieves up to max completed CALLs. If clear is set, their
+// results are retrieved and cleared as well. Completions whose result was
+// already retrieved by id are skipped, so stale entries never hide the ones
+// queued behind them.
+func (i *inputRegister) takeCompletions(id C.int, max int, clear bool) (resIDs []requestID, params [][]byte, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	in.m.RLock()
+	completions := in.completions
+	in.m.RUnlock()
+	if completions == nil {
+		err = ERR_NOT_SUPPORTED.asInt()
+		return
+	}
+	for len(resIDs) < max {
+		rs := completions.take(max - len(resIDs))
+		if len(rs) == 0 {
+			break
+		}
+		in.m.Lock()
+		for _, r := range rs {
+			resID := r.(requestID)
+			res, ok := in.results[resID]
+			if !ok {
+				// Already retrieved by id.
+				continue
+			}
+			resIDs = append(resIDs, resID)
+			if clear && res.err != NO_ERR.asInt() {
+				// Kept, so retrieving it by id returns the error.
+				params = append(params, nil)
+				continue
+			}
+			if clear {
+				params = append(params, res.params)
+				delete(in.results, resID)
+				atomic.AddInt32(&in.resultsReady, -1)
+			}
+		}
+		in.m.Unlock()
+	}
+	if len(resIDs) == 0 {
+		err = ERR_RESULT_NOT_ARRIVED.asInt()
+	}
+	return
 }
 
 func (i *inputRegister) listenResultAvailable(id C.int) (is bool, err C.int) {
 
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 
-	is = !in.listen.Empty()
+	is = !in.listen.empty()
 	return
 
 }
 
+func (i *inputRegister) waitListenResult(id C.int, timeout C.int) (is bool, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	is = in.s.wait(timeout, func() bool { return !in.listen.empty() })
+	return
+}
+
 func (i *inputRegister) nextListenResultUUID(id C.int) (resID uuid.UUID, err C.int) {
 
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 
-	if in.listen.Empty() {
+	res, ok := in.listen.preview()
+	if !ok {
 		err = ERR_NO_RESULT_AVAILABLE.asInt()
 		return
 	}
-	resID = in.listen.Preview().Request.UUID
+	resID = res.(*message.Result).Request.UUID
 	return
 }
 
 func (i *inputRegister) nextListenResultFunction(id C.int) (function string, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
-	if in.listen.Empty() {
+	defer in.release()
+	res, ok := in.listen.preview()
+	if !ok {
 		err = ERR_NO_RESULT_AVAILABLE.asInt()
 		return
 	}
-	function = in.listen.Preview().Request.Function
+	function = res.(*message.Result).Request.Function
 	return
 }
 
 func (i *inputRegister) nextListenResultRequestParameter(id C.int) (params []byte, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
-	if in.listen.Empty() {
+	defer in.release()
+	res, ok := in.listen.preview()
+	if !ok {
 		err = ERR_NO_RESULT_AVAILABLE.asInt()
 		return
 	}
-	params = in.listen.Preview().Request.Parameter()
+	params = res.(*message.Result).Request.Parameter()
 	return
 }
 
 func (i *inputRegister) nextListenResultParameter(id C.int) (params []byte, err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
-	if in.listen.Empty() {
+	defer in.release()
+	res, ok := in.listen.preview()
+	if !ok {
 		err = ERR_NO_RESULT_AVAILABLE.asInt()
 		return
 	}
-	params = in.listen.Preview().Parameter()
+	params = res.(*message.Result).Parameter()
 	return
 }
 
 func (i *inputRegister) clearListenResult(id C.int) (err C.int) {
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	if _, ok := in.listen.get(); !ok {
+		err = ERR_NO_RESULT_AVAILABLE.asInt()
+	}
+	return
+}
+
+func (i *inputRegister) takeListenResult(id C.int) (res *message.Result, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
-	if in.listen.Empty() {
+	defer in.release()
+	r, ok := in.listen.get()
+	if !ok {
 		err = ERR_NO_RESULT_AVAILABLE.asInt()
 		return
 	}
-	in.listen.Get()
+	res = r.(*message.Result)
 	return
 }
 
-func (i *inputRegister) callAllResultAvailable(id C.int, resID uuid.UUID) (is bool, err C.int) {
+func (i *inputRegister) callAllResultAvailable(id C.int, resID requestID) (is bool, err C.int) {
 
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	in.m.RLock()
-	defer in.m.RLock()
+	defer in.m.RUnlock()
 
 	res, ok := in.callall[resID]
 	if !ok {
 		err = ERR_INVALID_RESULT_ID.asInt()
 		return
 	}
-	is = !res.Empty()
+	is = !res.results.empty()
 	return
 
 }
 
-func (i *inputRegister) callAllResultParameter(id C.int, resID uuid.UUID) (p []byte, err C.int) {
+func (i *inputRegister) callAllResultParameter(id C.int, resID requestID) (p []byte, err C.int) {
 
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	in.m.RLock()
-	defer in.m.RLock()
+	defer in.m.RUnlock()
 
 	res, ok := in.callall[resID]
 	if !ok {
 		err = ERR_INVALID_RESULT_ID.asInt()
 		return
 	}
-	if res.Empty() {
+	r, ok := res.results.preview()
+	if !ok {
 		err = ERR_NO_RESULT_AVAILABLE.asInt()
+		return
 	}
-	p = res.Preview().Parameter()
+	p = r.(*message.Result).Parameter()
 
 	return
 
 }
 
-func (i *inputRegister) clearCallAllResult(id C.int, resID uuid.UUID) (err C.int) {
+func (i *inputRegister) clearCallAllResult(id C.int, resID requestID) (err C.int) {
 
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	in.m.RLock()
-	defer in.m.RLock()
+	defer in.m.RUnlock()
 
 	res, ok := in.callall[resID]
 	if !ok {
 		err = ERR_INVALID_RESULT_ID.asInt()
 		return
 	}
-	res.Get()
+	if _, ok := res.results.get(); !ok {
+		err = ERR_NO_RESULT_AVAILABLE.asInt()
+	}
 	return
 
 }
-func (i *inputRegister) clearCallAllRequest(id C.int, resID uuid.UUID) (err C.int) {
+func (i *inputRegister) clearCallAllRequest(id C.int, resID requestID) (err C.int) {
 
-	i.m.RLock()
-	defer i.m.RUnlock()
-	in, ok := i.register[id]
-	if !ok {
-		err = ERR_INVALID_INPUT.asInt()
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer in.release()
 	in.m.Lock()
-	defer in.m.Lock()
+	defer in.m.Unlock()
 
 	res, ok := in.callall[resID]
 	if !ok {
 		err = ERR_INVALID_RESULT_ID.asInt()
 		return
 	}
-	res.Stopped()
+	res.stop.Complete(nil)
 	delete(in.callall, resID)
 	return
 
 }
 
+// Queues of an input which can be bounded, they mirror the TVIO_QUEUE_*
+// defines in thingiverseio.h.
+const (
+	INPUT_QUEUE_LISTEN C.int = iota
+	INPUT_QUEUE_CHANGE
+)
+
+func (in *input) queue(which C.int) *queue {
+	switch which {
+	case INPUT_QUEUE_LISTEN:
+		return in.listen
+	case INPUT_QUEUE_CHANGE:
+		return in.propertyChanges
+	}
+	return nil
+}
+
+func (i *inputRegister) setQueueLimit(id C.int, which C.int, capacity int, policy C.int) (err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	q := in.queue(which)
+	if q == nil || !validPolicy(policy) {
+		err = ERR_INVALID_QUEUE.asInt()
+		return
+	}
+	q.setLimit(capacity, policy)
+	return
+}
+
+func (i *inputRegister) queueStats(id C.int, which C.int) (length int, dropped uint64, rejected uint64, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	q := in.queue(which)
+	if q == nil {
+		err = ERR_INVALID_QUEUE.asInt()
+		return
+	}
+	length, dropped, rejected = q.stats()
+	return
+}
+
+// stats fills in the statistics of an input.
+func (i *inputRegister) stats(id C.int, dst *inputStats) (err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	in.stats.load(dst)
+	in.m.RLock()
+	dst.resultsDepth = uint64(len(in.results))
+	dst.callAllDepth = uint64(len(in.callall))
+	in.m.RUnlock()
+	l, _, _ := in.listen.stats()
+	dst.listenDepth = uint64(l)
+	l, _, _ = in.propertyChanges.stats()
+	dst.changesDepth = uint64(l)
+	return
+}
+
+func (i *inputRegister) fd(id C.int) (fd C.int, err C.int) {
+	in, err := i.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer in.release()
+	fd, ok, err := in.s.fd(func() bool { return in.events() != 0 })
+	if !ok {
+		err = ERR_INVALID_INPUT.asInt()
+	}
+	return
+}
+
 var inputs = inputRegister{
-	m:        &sync.RWMutex{},
-	register: map[C.int]*input{},
+	handles: newHandleTable(),
 }
 
 //export new_input
@@ -719,6 +1413,33 @@ func input_interface(i C.int, iface_p **C.char, iface_size *C.int) C.int {
 	return err
 }
 
+//export input_fd
+func input_fd(i C.int, fd_p *C.int) C.int {
+	fd, err := inputs.fd(i)
+	if err == NO_ERR.asInt() {
+		*fd_p = fd
+	}
+	return err
+}
+
+//export input_function_id
+func input_function_id(i C.int, function *C.char, id *C.int) C.int {
+	fid, err := inputs.functionID(i, C.GoString(function))
+	if err == NO_ERR.asInt() {
+		*id = fid
+	}
+	return err
+}
+
+//export input_property_id
+func input_property_id(i C.int, property *C.char, id *C.int) C.int {
+	pid, err := inputs.propertyID(i, C.GoString(property))
+	if err == NO_ERR.asInt() {
+		*id = pid
+	}
+	return err
+}
+
 //export input_call
 func input_call(i C.int, function *C.char, params unsafe.Pointer, params_size C.int, request_id **C.char, request_id_size *C.int) C.int {
 	fun := C.GoString(function)
@@ -731,6 +1452,38 @@ func input_call(i C.int, function *C.char, params unsafe.Pointer, params_size C.
 	return err
 }
 
+//export input_call_bin
+func input_call_bin(i C.int, function *C.char, params unsafe.Pointer, params_size C.int, request_id unsafe.Pointer) C.int {
+	fun := C.GoString(function)
+	paramter := getParams(params, params_size)
+	res_id, err := inputs.call(i, fun, paramter)
+	if err == NO_ERR.asInt() {
+		putRequestID(request_id, requestKey(res_id))
+	}
+	return err
+}
+
+//export input_call_id
+func input_call_id(i C.int, function C.int, params unsafe.Pointer, params_size C.int, request_id **C.char, request_id_size *C.int) C.int {
+	paramter := getParams(params, params_size)
+	res_id, err := inputs.callByID(i, function, paramter)
+	if err == NO_ERR.asInt() {
+		*request_id = C.CString(string(res_id))
+		*request_id_size = C.int(len(res_id))
+	}
+	return err
+}
+
+//export input_call_id_bin
+func input_call_id_bin(i C.int, function C.int, params unsafe.Pointer, params_size C.int, request_id unsafe.Pointer) C.int {
+	paramter := getParams(params, params_size)
+	res_id, err := inputs.callByID(i, function, paramter)
+	if err == NO_ERR.asInt() {
+		putRequestID(request_id, requestKey(res_id))
+	}
+	return err
+}
+
 //export input_call_all
 func input_call_all(i C.int, function *C.char, params unsafe.Pointer, params_size C.int, request_id **C.char, request_id_size *C.int) C.int {
 	fun := C.GoString(function)
@@ -743,6 +1496,17 @@ func input_call_all(i C.int, function *C.char, params unsafe.Pointer, params_siz
 	return err
 }
 
+//export input_call_all_bin
+func input_call_all_bin(i C.int, function *C.char, params unsafe.Pointer, params_size C.int, request_id unsafe.Pointer) C.int {
+	fun := C.GoString(function)
+	paramter := getParams(params, params_size)
+	res_id, err := inputs.callAll(i, fun, paramter)
+	if err == NO_ERR.asInt() {
+		putRequestID(request_id, requestKey(res_id))
+	}
+	return err
+}
+
 //export input_trigger
 func input_trigger(i C.int, function *C.char, params unsafe.Pointer, params_size C.int) C.int {
 	fun := C.GoString(function)
@@ -751,6 +1515,13 @@ func input_trigger(i C.int, function *C.char, params unsafe.Pointer, params_size
 	return err
 }
 
+//export input_trigger_id
+func input_trigger_id(i C.int, function C.int, params unsafe.Pointer, params_size C.int) C.int {
+	paramter := getParams(params, params_size)
+	err := inputs.triggerByID(i, function, paramter)
+	return err
+}
+
 //export input_trigger_all
 func input_trigger_all(i C.int, function *C.char, params unsafe.Pointer, params_size C.int) C.int {
 	fun := C.GoString(function)
@@ -759,18 +1530,103 @@ func input_trigger_all(i C.int, function *C.char, params unsafe.Pointer, params_
 	return err
 }
 
+//export input_call_batch
+func input_call_batch(i C.int, n C.int, functions **C.char, params unsafe.Pointer, offsets *C.int, request_ids unsafe.Pointer, issued *C.int) C.int {
+	if issued != nil {
+		*issued = 0
+	}
+	funs, parameter, err := getBatch(n, functions, params, offsets)
+	if err != NO_ERR.asInt() || n == 0 {
+		return err
+	}
+	resIDs, err := inputs.callBatch(i, funs, parameter)
+	ids := unsafe.Slice((*requestID)(request_ids), int(n))
+	for k := range ids {
+		ids[k] = requestID{}
+	}
+	for k, resID := range resIDs {
+		ids[k], _ = toRequestID(resID)
+	}
+	if issued != nil {
+		*issued = C.int(len(resIDs))
+	}
+	return err
+}
+
+//export input_trigger_batch
+func input_trigger_batch(i C.int, n C.int, functions **C.char, params unsafe.Pointer, offsets *C.int, issued *C.int) C.int {
+	if issued != nil {
+		*issued = 0
+	}
+	funs, parameter, err := getBatch(n, functions, params, offsets)
+	if err != NO_ERR.asInt() || n == 0 {
+		return err
+	}
+	k, err := inputs.triggerBatch(i, funs, parameter)
+	if issued != nil {
+		*issued = C.int(k)
+	}
+	return err
+}
+
 //export input_call_result_available
 func input_call_result_available(i C.int, res_id *C.char, ready *C.int) C.int {
-	resID := uuid.UUID(C.GoString(res_id))
+	resID := cRequestID(res_id)
 	r, err := inputs.resultReady(i, resID)
 	boolToIntPtr(r, ready)
 	return err
 }
 
+//export input_call_result_available_bin
+func input_call_result_available_bin(i C.int, res_id unsafe.Pointer, ready *C.int) C.int {
+	r, err := inputs.resultReady(i, binRequestID(res_id))
+	boolToIntPtr(r, ready)
+	return err
+}
+
+//export input_call_result_wait
+func input_call_result_wait(i C.int, res_id *C.char, timeout C.int, ready *C.int) C.int {
+	resID := cRequestID(res_id)
+	r, err := inputs.waitResult(i, resID, timeout)
+	boolToIntPtr(r, ready)
+	return err
+}
+
+//export input_call_result_wait_bin
+func input_call_result_wait_bin(i C.int, res_id unsafe.Pointer, timeout C.int, ready *C.int) C.int {
+	r, err := inputs.waitResult(i, binRequestID(res_id), timeout)
+	boolToIntPtr(r, ready)
+	return err
+}
+
 //export input_call_result_params
 func input_call_result_params(i C.int, res_id *C.char, params *unsafe.Pointer, params_size *C.int) C.int {
-	resID := uuid.UUID(C.GoString(res_id))
-	p, err := inputs.resultParameter(i, resID)
+	resID := cRequestID(res_id)
+	p, err := inputs.resultParameter(i, resID, -1)
+	if err == NO_ERR.asInt() {
+		*params = unsafe.Pointer(C.CBytes(p))
+		*params_size = C.int(len(p))
+	}
+	return err
+}
+
+//export input_call_result_params_into
+func input_call_result_params_into(i C.int, res_id *C.char, buf unsafe.Pointer, capacity C.int, params_size *C.int) C.int {
+	resID := cRequestID(res_id)
+	if capacity < 0 {
+		// A negative maximum would take the value regardless of its size.
+		capacity = 0
+	}
+	p, err := inputs.resultParameter(i, resID, int(capacity))
+	if err == NO_ERR.asInt() || err == ERR_BUFFER_TOO_SMALL.asInt() {
+		err = copyInto(p, buf, capacity, params_size)
+	}
+	return err
+}
+
+//export input_call_result_params_bin
+func input_call_result_params_bin(i C.int, res_id unsafe.Pointer, params *unsafe.Pointer, params_size *C.int) C.int {
+	p, err := inputs.resultParameter(i, binRequestID(res_id), -1)
 	if err == NO_ERR.asInt() {
 		*params = unsafe.Pointer(C.CBytes(p))
 		*params_size = C.int(len(p))
@@ -778,6 +1634,70 @@ func input_call_result_params(i C.int, res_id *C.char, params *unsafe.Pointer, p
 	return err
 }
 
+//export input_completions_start
+func input_completions_start(i C.int) C.int {
+	return inputs.startCompletions(i)
+}
+
+//export input_completions_wait
+func input_completions_wait(i C.int, timeout C.int, is_p *C.int) C.int {
+	is, err := inputs.waitCompletions(i, timeout)
+	boolToIntPtr(is, is_p)
+	return err
+}
+
+//export input_completions_take
+func input_completions_take(i C.int, max C.int, res_ids unsafe.Pointer, offsets *C.int, params *unsafe.Pointer, n *C.int) C.int {
+	*n = 0
+	resIDs, ps, err := inputs.takeCompletions(i, int(max), params != nil)
+	if err != NO_ERR.asInt() {
+		return err
+	}
+	for k, resID := range resIDs {
+		putRequestID(unsafe.Add(res_ids, 16*k), resID)
+	}
+	*n = C.int(len(resIDs))
+	if params == nil {
+		return err
+	}
+	size := 0
+	for _, p := range ps {
+		size += len(p)
+	}
+	base := C.malloc(C.size_t(size + 1))
+	buf := unsafe.Slice((*byte)(base), size+1)
+	offs := unsafe.Slice(offsets, len(ps)+1)
+	pos := 0
+	for k, p := range ps {
+		offs[k] = C.int(pos)
+		pos += copy(buf[pos:], p)
+	}
+	offs[len(ps)] = C.int(pos)
+	*params = base
+	return err
+}
+
+//export input_queue_set
+func input_queue_set(i C.int, queue C.int, capacity C.int, policy C.int) C.int {
+	return inputs.setQueueLimit(i, queue, int(capacity), policy)
+}
+
+//export input_queue_stats
+func input_queue_stats(i C.int, queue C.int, length *C.int, dropped *C.ulonglong, rejected *C.ulonglong) C.int {
+	l, d, r, err := inputs.queueStats(i, queue)
+	if err == NO_ERR.asInt() {
+		*length = C.int(l)
+		*dropped = C.ulonglong(d)
+		*rejected = C.ulonglong(r)
+	}
+	return err
+}
+
+//export input_stats
+func input_stats(i C.int, stats unsafe.Pointer) C.int {
+	return inputs.stats(i, (*inputStats)(stats))
+}
+
 //export input_listen_start
 func input_listen_start(i C.int, function *C.char) C.int {
 	return inputs.startListen(i, C.GoString(function))
@@ -795,6 +1715,13 @@ func input_listen_result_available(i C.int, is_p *C.int) C.int {
 	return err
 }
 
+//export input_listen_result_wait
+func input_listen_result_wait(i C.int, timeout C.int, is_p *C.int) C.int {
+	is, err := inputs.waitListenResult(i, timeout)
+	boolToIntPtr(is, is_p)
+	return err
+}
+
 //export input_listen_result_id
 func input_listen_result_id(i C.int, result_id **C.char, result_id_size *C.int) C.int {
 	resID, err := inputs.nextListenResultUUID(i)
@@ -805,6 +1732,15 @@ func input_listen_result_id(i C.int, result_id **C.char, result_id_size *C.int)
 	return err
 }
 
+//export input_listen_result_id_bin
+func input_listen_result_id_bin(i C.int, result_id unsafe.Pointer) C.int {
+	resID, err := inputs.nextListenResultUUID(i)
+	if err == NO_ERR.asInt() {
+		putRequestID(result_id, requestKey(resID))
+	}
+	return err
+}
+
 //export input_listen_result_function
 func input_listen_result_function(i C.int, function **C.char, function_size *C.int) C.int {
 	fun, err := inputs.nextListenResultFunction(i)
@@ -825,6 +1761,15 @@ func input_listen_result_request_params(i C.int, params *unsafe.Pointer, params_
 	return err
 }
 
+//export input_listen_result_request_params_into
+func input_listen_result_request_params_into(i C.int, buf unsafe.Pointer, capacity C.int, params_size *C.int) C.int {
+	p, err := inputs.nextListenResultRequestParameter(i)
+	if err == NO_ERR.asInt() {
+		err = copyInto(p, buf, capacity, params_size)
+	}
+	return err
+}
+
 //export input_listen_result_params
 func input_listen_result_params(i C.int, params *unsafe.Pointer, params_size *C.int) C.int {
 	p, err := inputs.nextListenResultParameter(i)
@@ -835,24 +1780,77 @@ func input_listen_result_params(i C.int, params *unsafe.Pointer, params_size *C.
 	return err
 }
 
+//export input_listen_result_params_into
+func input_listen_result_params_into(i C.int, buf unsafe.Pointer, capacity C.int, params_size *C.int) C.int {
+	p, err := inputs.nextListenResultParameter(i)
+	if err == NO_ERR.asInt() {
+		err = copyInto(p, buf, capacity, params_size)
+	}
+	return err
+}
+
 //export input_listen_result_clear
 func input_listen_result_clear(i C.int) C.int {
 	err := inputs.clearListenResult(i)
 	return err
 }
 
+//export input_listen_result_take
+func input_listen_result_take(i C.int, result_id **C.char, function **C.char, request_params *unsafe.Pointer, request_params_size *C.int, params *unsafe.Pointer, params_size *C.int) C.int {
+	res, err := inputs.takeListenResult(i)
+	if err == NO_ERR.asInt() {
+		rp := res.Request.Parameter()
+		p := res.Parameter()
+		fields := packFields([]byte(res.Request.UUID), []byte(res.Request.Function), rp, p)
+		*result_id = (*C.char)(fields[0])
+		*function = (*C.char)(fields[1])
+		*request_params = fields[2]
+		*request_params_size = C.int(len(rp))
+		*params = fields[3]
+		*params_size = C.int(len(p))
+	}
+	return err
+}
+
 //export input_call_all_next_result_available
 func input_call_all_next_result_available(i C.int, res_id *C.char, is_p *C.int) C.int {
-	resID := uuid.UUID(C.GoString(res_id))
+	resID := cRequestID(res_id)
 	is, err := inputs.callAllResultAvailable(i, resID)
 	boolToIntPtr(is, is_p)
 	return err
 }
 
+//export input_call_all_next_result_available_bin
+func input_call_all_next_result_available_bin(i C.int, res_id unsafe.Pointer, is_p *C.int) C.int {
+	is, err := inputs.callAllResultAvailable(i, binRequestID(res_id))
+	boolToIntPtr(is, is_p)
+	return err
+}
+
 //export input_call_all_next_result_params
 func input_call_all_next_result_params(i C.int, res_id *C.char, params *unsafe.Pointer, params_size *C.int) C.int {
-	resID := uuid.UUID(C.GoString(res_id))
+	resID := cRequestID(res_id)
+	p, err := inputs.callAllResultParameter(i, resID)
+	if err == NO_ERR.asInt() {
+		*params = unsafe.Pointer(C.CBytes(p))
+		*params_size = C.int(len(p))
+	}
+	return err
+}
+
+//export input_call_all_next_result_params_into
+func input_call_all_next_result_params_into(i C.int, res_id *C.char, buf unsafe.Pointer, capacity C.int, params_size *C.int) C.int {
+	resID := cRequestID(res_id)
 	p, err := inputs.callAllResultParameter(i, resID)
+	if err == NO_ERR.asInt() {
+		err = copyInto(p, buf, capacity, params_size)
+	}
+	return err
+}
+
+//export input_call_all_next_result_params_bin
+func input_call_all_next_result_params_bin(i C.int, res_id unsafe.Pointer, params *unsafe.Pointer, params_size *C.int) C.int {
+	p, err := inputs.callAllResultParameter(i, binRequestID(res_id))
 	if err == NO_ERR.asInt() {
 		*params = unsafe.Pointer(C.CBytes(p))
 		*params_size = C.int(len(p))
@@ -862,18 +1860,28 @@ func input_call_all_next_result_params(i C.int, res_id *C.char, params *unsafe.P
 
 //export input_call_all_next_result_clear
 func input_call_all_next_result_clear(i C.int, res_id *C.char) C.int {
-	resID := uuid.UUID(C.GoString(res_id))
+	resID := cRequestID(res_id)
 	err := inputs.clearCallAllResult(i, resID)
 	return err
 }
 
+//export input_call_all_next_result_clear_bin
+func input_call_all_next_result_clear_bin(i C.int, res_id unsafe.Pointer) C.int {
+	return inputs.clearCallAllResult(i, binRequestID(res_id))
+}
+
 //export input_call_all_request_clear
 func input_call_all_request_clear(i C.int, res_id *C.char) C.int {
-	resID := uuid.UUID(C.GoString(res_id))
+	resID := cRequestID(res_id)
 	err := inputs.clearCallAllRequest(i, resID)
 	return err
 }
 
+//export input_call_all_request_clear_bin
+func input_call_all_request_clear_bin(i C.int, res_id unsafe.Pointer) C.int {
+	return inputs.clearCallAllRequest(i, binRequestID(res_id))
+}
+
 //export input_property_get
 func input_property_get(i C.int, property *C.char, value_p *unsafe.Pointer, value_size *C.int) C.int {
 	prop := C.GoString(property)
@@ -885,6 +1893,47 @@ func input_property_get(i C.int, property *C.char, value_p *unsafe.Pointer, valu
 	return err
 }
 
+//export input_property_get_into
+func input_property_get_into(i C.int, property *C.char, buf unsafe.Pointer, capacity C.int, value_size *C.int) C.int {
+	prop := C.GoString(property)
+	p, err := inputs.getProperty(i, prop)
+	if err == NO_ERR.asInt() {
+		err = copyInto(p, buf, capacity, value_size)
+	}
+	return err
+}
+
+//export input_property_get_id
+func input_property_get_id(i C.int, property C.int, value_p *unsafe.Pointer, value_size *C.int) C.int {
+	p, err := inputs.getPropertyByID(i, property)
+	if err == NO_ERR.asInt() {
+		*value_p = unsafe.Pointer(C.CBytes(p))
+		*value_size = C.int(len(p))
+	}
+	return err
+}
+
+//export input_property_get_into_id
+func input_property_get_into_id(i C.int, property C.int, buf unsafe.Pointer, capacity C.int, value_size *C.int) C.int {
+	p, err := inputs.getPropertyByID(i, property)
+	if err == NO_ERR.asInt() {
+		err = copyInto(p, buf, capacity, value_size)
+	}
+	return err
+}
+
+//export input_property_mirror
+func input_property_mirror(i C.int, property *C.char, capacity C.int, mirror *unsafe.Pointer) C.int {
+	if capacity < 0 {
+		capacity = 0
+	}
+	m, err := inputs.mirrorProperty(i, C.GoString(property), int(capacity))
+	if err == NO_ERR.asInt() {
+		*mirror = m
+	}
+	return err
+}
+
 //export input_property_update
 func input_property_update(i C.int, property *C.char) C.int {
 	prop := C.GoString(property)
@@ -903,7 +1952,7 @@ func input_property_update_available(i C.int, property *C.char, is_p *C.int) C.i
 //export input_property_update_get
 func input_property_update_get(i C.int, property *C.char, value_p *unsafe.Pointer, value_size *C.int) C.int {
 	prop := C.GoString(property)
-	p, err := inputs.getPropertyUpdate(i, prop)
+	p, err := inputs.getPropertyUpdate(i, prop, -1)
 	if err == NO_ERR.asInt() {
 		*value_p = unsafe.Pointer(C.CBytes(p))
 		*value_size = C.int(len(p))
@@ -911,9 +1960,28 @@ func input_property_update_get(i C.int, property *C.char, value_p *unsafe.Pointe
 	return err
 }
 
+//export input_property_update_get_into
+func input_property_update_get_into(i C.int, property *C.char, buf unsafe.Pointer, capacity C.int, value_size *C.int) C.int {
+	prop := C.GoString(property)
+	if capacity < 0 {
+		// A negative maximum would take the value regardless of its size.
+		capacity = 0
+	}
+	p, err := inputs.getPropertyUpdate(i, prop, int(capacity))
+	if err == NO_ERR.asInt() || err == ERR_BUFFER_TOO_SMALL.asInt() {
+		err = copyInto(p, buf, capacity, value_size)
+	}
+	return err
+}
+
 //export input_change_start_observe
 func input_change_start_observe(i C.int, property *C.char) C.int {
-	return inputs.startObserve(i, C.GoString(property))
+	return inputs.startObserve(i, C.GoString(property), false)
+}
+
+//export input_change_start_observe_coalesced
+func input_change_start_observe_coalesced(i C.int, property *C.char) C.int {
+	return inputs.startObserve(i, C.GoString(property), true)
 }
 
 //export input_change_stop_observe
@@ -928,6 +1996,13 @@ func input_change_available(i C.int, is_p *C.int) C.int {
 	return err
 }
 
+//export input_change_wait
+func input_change_wait(i C.int, timeout C.int, is_p *C.int) C.int {
+	is, err := inputs.waitPropertyChanged(i, timeout)
+	boolToIntPtr(is, is_p)
+	return err
+}
+
 //export input_change_property
 func input_change_property(i C.int, property **C.char, property_size *C.int) C.int {
 	p, err := inputs.nextChangeProperty(i)
@@ -948,6 +2023,27 @@ func input_change_value(i C.int, value_p *unsafe.Pointer, value_size *C.int) C.i
 	return err
 }
 
+//export input_change_value_into
+func input_change_value_into(i C.int, buf unsafe.Pointer, capacity C.int, value_size *C.int) C.int {
+	p, err := inputs.nextChangeValue(i)
+	if err == NO_ERR.asInt() {
+		err = copyInto(p, buf, capacity, value_size)
+	}
+	return err
+}
+
+//export input_change_take
+func input_change_take(i C.int, property **C.char, value_p *unsafe.Pointer, value_size *C.int) C.int {
+	c, err := inputs.takeChange(i)
+	if err == NO_ERR.asInt() {
+		fields := packFields([]byte(c.name), c.value)
+		*property = (*C.char)(fields[0])
+		*value_p = fields[1]
+		*value_size = C.int(len(c.value))
+	}
+	return err
+}
+
 //export input_change_clear
 func input_change_clear(i C.int) C.int {
 	err := inputs.clearNextChange(i)
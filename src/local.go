@@ -0,0 +1,117 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import (
+	"crypto/rand"
+	"fmt"
+	"os"
+	"sync"
+
+	"github.com/ThingiverseIO/uuid"
+)
+
+// localPeers indexes the inputs and outputs of this process by interface, so
+// CALLs between them can bypass the network.
+type localPeers struct {
+	m       *sync.RWMutex
+	inputs  map[string]int
+	outputs map[string][]*output
+}
+
+// localEnabled allows the in-process path. Setting TVIO_LOCAL=0 disables it,
+// so CALLs between handles of one process go through the core, e.g. to test
+// the network path.
+var localEnabled = os.Getenv("TVIO_LOCAL") != "0"
+
+var locals = localPeers{
+	m:       &sync.RWMutex{},
+	inputs:  map[string]int{},
+	outputs: map[string][]*output{},
+}
+
+func (l *localPeers) addInput(iface string) {
+	l.m.Lock()
+	defer l.m.Unlock()
+	l.inputs[iface]++
+}
+
+func (l *localPeers) removeInput(iface string) {
+	l.m.Lock()
+	defer l.m.Unlock()
+	l.inputs[iface]--
+	if l.inputs[iface] <= 0 {
+		delete(l.inputs, iface)
+	}
+}
+
+func (l *localPeers) hasInput(iface string) bool {
+	if !localEnabled {
+		return false
+	}
+	l.m.RLock()
+	defer l.m.RUnlock()
+	return l.inputs[iface] > 0
+}
+
+func (l *localPeers) addOutput(out *output) {
+	l.m.Lock()
+	defer l.m.Unlock()
+	l.outputs[out.iface] = append(l.outputs[out.iface], out)
+}
+
+func (l *localPeers) removeOutput(out *output) {
+	l.m.Lock()
+	defer l.m.Unlock()
+	outs := l.outputs[out.iface]
+	for n, o := range outs {
+		if o == out {
+			outs = append(outs[:n:n], outs[n+1:]...)
+			break
+		}
+	}
+	if len(outs) == 0 {
+		delete(l.outputs, out.iface)
+		return
+	}
+	l.outputs[out.iface] = outs
+}
+
+// output returns the first local output implementing iface, or nil. The
+// output may be removed concurrently, callers have to acquire it.
+func (l *localPeers) output(iface string) *output {
+	if !localEnabled {
+		return nil
+	}
+	l.m.RLock()
+	defer l.m.RUnlock()
+	if outs := l.outputs[iface]; len(outs) != 0 {
+		return outs[0]
+	}
+	return nil
+}
+
+// newUUID creates a random (version 4) id for requests which never reach the
+// core.
+func newUUID() uuid.UUID {
+	var b [16]byte
+	rand.Read(b[:])
+	b[6] = b[6]&0x0f | 0x40
+	b[8] = b[8]&0x3f | 0x80
+	return uuid.UUID(fmt.Sprintf("%x-%x-%x-%x-%x", b[0:4], b[4:6], b[6:8], b[8:10], b[10:]))
+}
@@ -17,6 +17,7 @@
 
 package main
 
+// #include <stdlib.h>
 import "C"
 
 import (
@@ -24,6 +25,7 @@ import (
 
 	"github.com/ThingiverseIO/thingiverseio"
 	"github.com/ThingiverseIO/thingiverseio/descriptor"
+	"github.com/ThingiverseIO/uuid"
 )
 
 func main() {
@@ -60,6 +62,144 @@ func getParams(parameter unsafe.Pointer, parameter_size C.int) (params []byte) {
 	return
 }
 
+// borrowParams wraps host memory without copying it. The host must keep the
+// memory valid until the library releases it.
+func borrowParams(parameter unsafe.Pointer, parameter_size C.int) (params []byte) {
+	if parameter == nil || parameter_size <= 0 {
+		return
+	}
+	params = unsafe.Slice((*byte)(parameter), int(parameter_size))
+	return
+}
+
+// getBatch converts n names and their packed parameters, where the
+// parameters of entry k start at offsets[k] and end at offsets[k+1]. The
+// parameters are copied once and sliced per entry. Offsets which do not
+// start at 0 or decrease are rejected with ERR_MALFORMED_PARAMETERS.
+func getBatch(n C.int, names **C.char, parameter unsafe.Pointer, offsets *C.int) (ns []string, params [][]byte, err C.int) {
+	if n < 0 || n > 0 && (names == nil || offsets == nil) {
+		err = ERR_MALFORMED_PARAMETERS.asInt()
+		return
+	}
+	if n == 0 {
+		return
+	}
+	offs := unsafe.Slice(offsets, int(n)+1)
+	if offs[0] != 0 {
+		err = ERR_MALFORMED_PARAMETERS.asInt()
+		return
+	}
+	for k := 0; k < int(n); k++ {
+		if offs[k] > offs[k+1] {
+			err = ERR_MALFORMED_PARAMETERS.asInt()
+			return
+		}
+	}
+	if parameter == nil && offs[n] != 0 {
+		err = ERR_MALFORMED_PARAMETERS.asInt()
+		return
+	}
+	cnames := unsafe.Slice(names, int(n))
+	all := getParams(parameter, offs[n])
+	ns = make([]string, n)
+	params = make([][]byte, n)
+	for k := range cnames {
+		ns[k] = C.GoString(cnames[k])
+		params[k] = all[offs[k]:offs[k+1]:offs[k+1]]
+	}
+	return
+}
+
+// requestID is the binary form of a request UUID.
+type requestID [16]byte
+
+// toRequestID parses the hex digits of a UUID, ignoring the dashes.
+func toRequestID(id uuid.UUID) (rid requestID, ok bool) {
+	n := 0
+	for k := 0; k < len(id); k++ {
+		if id[k] == '-' {
+			continue
+		}
+		v, valid := fromHex(id[k])
+		if !valid || n == 2*len(rid) {
+			return
+		}
+		rid[n/2] |= v << (4 * uint(1-n%2))
+		n++
+	}
+	ok = n == 2*len(rid)
+	return
+}
+
+// requestKey converts a UUID created by the core, which is always valid.
+func requestKey(id uuid.UUID) (rid requestID) {
+	rid, _ = toRequestID(id)
+	return
+}
+
+// cRequestID parses a UUID given by the host. An invalid UUID yields the
+// zero id, which never matches a request.
+func cRequestID(id *C.char) (rid requestID) {
+	rid, _ = toRequestID(uuid.UUID(C.GoString(id)))
+	return
+}
+
+// binRequestID reads a binary UUID from host owned storage.
+func binRequestID(id unsafe.Pointer) requestID {
+	return *(*requestID)(id)
+}
+
+func putRequestID(id unsafe.Pointer, rid requestID) {
+	*(*requestID)(id) = rid
+}
+
+func fromHex(c byte) (v byte, ok bool) {
+	switch {
+	case '0' <= c && c <= '9':
+		return c - '0', true
+	case 'a' <= c && c <= 'f':
+		return c - 'a' + 10, true
+	case 'A' <= c && c <= 'F':
+		return c - 'A' + 10, true
+	}
+	return
+}
+
+// packFields copies all fields into a single C allocation, each one followed
+// by a terminating zero byte. It returns a pointer to every field, the first
+// one is the start of the allocation and is the only one the host has to free.
+func packFields(fields ...[]byte) (ptrs []unsafe.Pointer) {
+	size := 0
+	for _, f := range fields {
+		size += len(f) + 1
+	}
+	base := C.malloc(C.size_t(size))
+	buf := unsafe.Slice((*byte)(base), size)
+	ptrs = make([]unsafe.Pointer, len(fields))
+	pos := 0
+	for n, f := range fields {
+		ptrs[n] = unsafe.Pointer(&buf[pos])
+		pos += copy(buf[pos:], f)
+		buf[pos] = 0
+		pos++
+	}
+	return
+}
+
+// copyInto copies p into a host supplied buffer and sets size to the length
+// of p. If the buffer is too small, nothing is copied and ERR_BUFFER_TOO_SMALL
+// is returned, so the host can retry with a buffer of the reported size.
+func copyInto(p []byte, buf unsafe.Pointer, capacity C.int, size *C.int) C.int {
+	*size = C.int(len(p))
+	if len(p) > 0 && len(p) > int(capacity) {
+		return ERR_BUFFER_TOO_SMALL.asInt()
+	}
+	if len(p) != 0 {
+		copy(unsafe.Slice((*byte)(buf), len(p)), p)
+	}
+	return NO_ERR.asInt()
+}
+
 func boolToIntPtr(b bool, ptr *C.int) {
 	if b {
 		*ptr = 1
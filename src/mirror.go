@@ -0,0 +1,110 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+/*
+#include <stdlib.h>
+
+typedef struct {
+	unsigned int seq;
+	int size;
+	int capacity;
+	char data[1];
+} property_mirror;
+
+static char* property_mirror_data(property_mirror* m) {
+	return m->data;
+}
+*/
+import "C"
+
+import (
+	"sync"
+	"sync/atomic"
+	"unsafe"
+)
+
+// propertyMirror publishes the value of a property in C memory, guarded by a
+// sequence counter which is odd while the value is written. Hosts read it
+// with tvio_property_mirror_read without calling into Go. The layout mirrors
+// tvio_property_mirror in thingiverseio.h.
+type propertyMirror struct {
+	m      *sync.Mutex
+	p      *C.property_mirror
+	data   []byte
+	stored bool
+}
+
+func newPropertyMirror(capacity int) *propertyMirror {
+	size := unsafe.Sizeof(C.property_mirror{})
+	if n := unsafe.Offsetof(C.property_mirror{}.data) + uintptr(capacity); n > size {
+		size = n
+	}
+	p := (*C.property_mirror)(C.calloc(1, C.size_t(size)))
+	p.capacity = C.int(capacity)
+	return &propertyMirror{
+		m:    &sync.Mutex{},
+		p:    p,
+		data: unsafe.Slice((*byte)(unsafe.Pointer(C.property_mirror_data(p))), capacity),
+	}
+}
+
+// store publishes value. A value larger than the capacity only publishes its
+// size, readers then report ERR_BUFFER_TOO_SMALL.
+func (m *propertyMirror) store(value []byte) {
+	m.m.Lock()
+	defer m.m.Unlock()
+	m.write(value)
+}
+
+// storeInitial publishes value unless a change was stored already.
+func (m *propertyMirror) storeInitial(value []byte) {
+	m.m.Lock()
+	defer m.m.Unlock()
+	if !m.stored {
+		m.write(value)
+	}
+}
+
+func (m *propertyMirror) write(value []byte) {
+	if m.p == nil {
+		return
+	}
+	m.stored = true
+	seq := (*uint32)(unsafe.Pointer(&m.p.seq))
+	atomic.AddUint32(seq, 1)
+	copy(m.data, value)
+	atomic.StoreInt32((*int32)(unsafe.Pointer(&m.p.size)), int32(len(value)))
+	atomic.AddUint32(seq, 1)
+}
+
+func (m *propertyMirror) capacity() int {
+	return len(m.data)
+}
+
+func (m *propertyMirror) pointer() unsafe.Pointer {
+	return unsafe.Pointer(m.p)
+}
+
+func (m *propertyMirror) free() {
+	m.m.Lock()
+	defer m.m.Unlock()
+	C.free(unsafe.Pointer(m.p))
+	m.p = nil
+	m.data = nil
+}
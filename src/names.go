@@ -0,0 +1,88 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import "C"
+
+import "github.com/ThingiverseIO/thingiverseio/descriptor"
+
+// names numbers the functions and properties of a descriptor in the order
+// they are declared. Hosts resolve a name to its id once and pass the id to
+// the *_id variants of the hot calls, which then neither convert a C string
+// nor look the name up. It is immutable after creation.
+type names struct {
+	functions   []string
+	properties  []string
+	functionIDs map[string]C.int
+	propertyIDs map[string]C.int
+}
+
+func newNames(d descriptor.Descriptor) *names {
+	n := &names{
+		functionIDs: map[string]C.int{},
+		propertyIDs: map[string]C.int{},
+	}
+	for _, f := range d.Functions {
+		n.functionIDs[f.Name] = C.int(len(n.functions))
+		n.functions = append(n.functions, f.Name)
+	}
+	for _, p := range d.Properties {
+		n.propertyIDs[p.Name] = C.int(len(n.properties))
+		n.properties = append(n.properties, p.Name)
+	}
+	return n
+}
+
+func (n *names) hasFunction(function string) bool {
+	_, ok := n.functionIDs[function]
+	return ok
+}
+
+func (n *names) functionID(function string) (id C.int, err C.int) {
+	id, ok := n.functionIDs[function]
+	if !ok {
+		err = ERR_INVALID_FUNCTION.asInt()
+	}
+	return
+}
+
+func (n *names) function(id C.int) (function string, err C.int) {
+	if id < 0 || int(id) >= len(n.functions) {
+		err = ERR_INVALID_FUNCTION.asInt()
+		return
+	}
+	function = n.functions[id]
+	return
+}
+
+func (n *names) propertyID(property string) (id C.int, err C.int) {
+	id, ok := n.propertyIDs[property]
+	if !ok {
+		err = ERR_INVALID_PROPERTY.asInt()
+	}
+	return
+}
+
+func (n *names) property(id C.int) (property string, err C.int) {
+	if id < 0 || int(id) >= len(n.properties) {
+		err = ERR_INVALID_PROPERTY.asInt()
+		return
+	}
+	property = n.properties[id]
+	return
+}
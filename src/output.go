@@ -21,6 +21,7 @@ import "C"
 
 import (
 	"sync"
+	"time"
 	"unsafe"
 
 	"github.com/ThingiverseIO/thingiverseio/config"
@@ -30,11 +31,95 @@ import (
 	"github.com/ThingiverseIO/uuid"
 )
 
+// request is a request waiting for its reply. It either arrived through the
+// core or from an input in the same process.
+type request struct {
+	UUID     uuid.UUID
+	Function string
+	params   []byte
+	core     *message.Request
+	local    *pendingResult
+	shm      *shmConn
+	arrived  time.Time
+}
+
+func fromCore(r *message.Request) *request {
+	return &request{
+		UUID:     r.UUID,
+		Function: r.Function,
+		params:   r.Parameter(),
+		core:     r,
+	}
+}
+
+func (r *request) Parameter() []byte {
+	return r.params
+}
+
+// reply sends the result back the way the request came. Borrowed parameters
+// are only sent in place over shared memory, which writes them to the ring
+// before returning. The input keeps local results and the core may serialize
+// after Reply returns, so both get a copy.
+func (r *request) reply(c core.OutputCore, params []byte, borrowed bool) {
+	if borrowed && r.shm == nil {
+		params = append([]byte(nil), params...)
+	}
+	switch {
+	case r.local != nil:
+		r.local.complete(params)
+	case r.shm != nil:
+		r.shm.send(r.UUID, "", params)
+	default:
+		c.Reply(r.core, params)
+	}
+}
+
+// fail answers the request of an input in this process or on the other end
+// of a shared memory connection with an error.
+func (r *request) fail(err C.int) {
+	switch {
+	case r.local != nil:
+		r.local.fail(err)
+	case r.shm != nil:
+		r.shm.sendError(r.UUID, int32(err))
+	}
+}
+
+// drop is called by the request queue if it drops the request after it was
+// accepted.
+func (r *request) drop() {
+	r.fail(ERR_QUEUE_FULL.asInt())
+}
+
+// requestHandler is a C callback which receives requests directly.
+type requestHandler struct {
+	fn       unsafe.Pointer
+	userdata unsafe.Pointer
+}
+
 type output struct {
+	handle
+	id            C.int
+	iface         string
+	names         *names
 	m             *sync.RWMutex
 	c             core.OutputCore
-	requests      *message.RequestCollector
-	request_cache map[uuid.UUID]*message.Request
+	s             *signal
+	requests      *queue
+	request_cache map[requestID]*request
+	handler       *requestHandler
+	pool          *servePool
+	closed        bool
+	shm           *shmListener
+	stats         *outputStats
+}
+
+// newOutputCore creates the core behind an output. The Go benchmarks replace it
+// to measure the binding without networking.
+var newOutputCore = func(d descriptor.Descriptor) (core.OutputCore, error) {
+	cfg := config.Configure()
+	tracker, provider := core.DefaultBackends()
+	return core.NewOutputCore(d, cfg, tracker, provider...)
 }
 
 func newOutput(desc string) (o *output, err C.int) {
@@ -43,142 +128,380 @@ func newOutput(desc string) (o *output, err C.int) {
 		err = ERR_INVALID_DESCRIPTOR.asInt()
 		return
 	}
-	cfg := config.Configure()
-	tracker, provider := core.DefaultBackends()
-	c, nerr := core.NewOutputCore(d, cfg, tracker, provider...)
+	c, nerr := newOutputCore(d)
 	if nerr != nil {
 		err = ERR_NETWORK.asInt()
 		return
 	}
+	s := newSignal()
 	o = &output{
+		handle:        newHandle(c.Shutdown),
+		iface:         c.Interface(),
+		names:         newNames(d),
 		m:             &sync.RWMutex{},
 		c:             c,
-		requests:      message.NewRequestCollector(),
-		request_cache: map[uuid.UUID]*message.Request{},
+		s:             s,
+		requests:      newQueue(s),
+		request_cache: map[requestID]*request{},
+		stats:         &outputStats{},
 	}
-	o.requests.AddStream(c.RequestStream())
+	c.RequestStream().Listen(func(r *message.Request) {
+		o.dispatch(fromCore(r))
+	})
+	o.shm = newShmListener(o.iface, c.UUID(), func(r *request) int32 {
+		if o.dispatch(r) {
+			return 0
+		}
+		if o.removed() {
+			return int32(ERR_INVALID_OUTPUT)
+		}
+		return int32(ERR_QUEUE_FULL)
+	})
 	o.c.Run()
 	return
 }
 
-type outputRegister struct {
-	n        int
-	m        *sync.RWMutex
-	register map[C.int]*output
+// dispatch hands an incoming request to the serve workers or the request
+// handler if one is set, otherwise it is queued until the host retrieves it.
+// It returns false if the output is removed or the request queue dropped or
+// rejected the request.
+func (o *output) dispatch(r *request) bool {
+	r.arrived = time.Now()
+	o.stats.received(r.params)
+	// The pool is only replaced under the write lock, so producers share the
+	// read lock and the deques do the rest.
+	o.m.RLock()
+	if o.closed {
+		o.m.RUnlock()
+		return false
+	}
+	if o.pool != nil {
+		o.pool.add(r)
+		o.m.RUnlock()
+		return true
+	}
+	h := o.handler
+	o.m.RUnlock()
+	if h == nil {
+		return o.requests.add(r)
+	}
+	o.m.Lock()
+	if o.closed {
+		o.m.Unlock()
+		return false
+	}
+	o.request_cache[requestKey(r.UUID)] = r
+	o.m.Unlock()
+	o.stats.queueTime.record(0)
+	callRequestHandler(h.fn, h.userdata, o.id, r)
+	return true
 }
 
-func (o *outputRegister) next() (n int) {
-	n = o.n
-	o.n++
-	return
+// removed reports whether the output was removed.
+func (o *output) removed() bool {
+	o.m.RLock()
+	defer o.m.RUnlock()
+	return o.closed
+}
+
+// failLocal fails the requests of inputs in this process, which would
+// otherwise wait for a reply forever.
+func failLocal(rs []*request) {
+	for _, r := range rs {
+		if r.local != nil {
+			r.local.fail(ERR_INVALID_OUTPUT.asInt())
+		}
+	}
+}
+
+// retrieved records how long a request waited for the host.
+func (o *output) retrieved(r *request) {
+	o.stats.queueTime.record(time.Since(r.arrived))
+}
+
+type outputRegister struct {
+	handles *handleTable
 }
 
 func (o *outputRegister) new(desc string) (idOrErr C.int) {
-	o.m.Lock()
-	defer o.m.Unlock()
 	out, idOrErr := newOutput(desc)
 	if idOrErr != NO_ERR.asInt() {
 		return
 	}
-	idOrErr = C.int(o.next())
-	o.register[idOrErr] = out
+	idOrErr = o.handles.add(out)
+	out.id = idOrErr
+	locals.addOutput(out)
 	return
 }
 
-func (o *outputRegister) connected(id C.int) (is bool, err C.int) {
-	o.m.Lock()
-	defer o.m.Unlock()
-	out, ok := o.register[id]
+// get looks up an output and takes a reference, which must be released.
+func (o *outputRegister) get(id C.int) (out *output, err C.int) {
+	h, ok := o.handles.get(id)
 	if !ok {
 		err = ERR_INVALID_OUTPUT.asInt()
 		return
 	}
-	is = out.c.Connected()
+	out = h.(*output)
+	if !out.acquire() {
+		err = ERR_INVALID_OUTPUT.asInt()
+	}
+	return
+}
+
+func (o *outputRegister) connected(id C.int) (is bool, err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	is = out.c.Connected() || locals.hasInput(out.iface)
 	return
 }
 
 func (o *outputRegister) iface(id C.int) (iface string, err C.int) {
-	o.m.Lock()
-	defer o.m.Unlock()
-	out, ok := o.register[id]
-	if !ok {
-		err = ERR_INVALID_OUTPUT.asInt()
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer out.release()
 	iface = out.c.Interface()
 	return
 }
 
 func (o *outputRegister) uuid(id C.int) (iID uuid.UUID, err C.int) {
-	o.m.Lock()
-	defer o.m.Unlock()
-	out, ok := o.register[id]
-	if !ok {
-		err = ERR_INVALID_OUTPUT.asInt()
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer out.release()
 	iID = out.c.UUID()
 	return
 }
 
 func (o *outputRegister) remove(id C.int) (err C.int) {
-	o.m.Lock()
-	defer o.m.Unlock()
-	out, ok := o.register[id]
-	if !ok {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	if _, ok := o.handles.remove(id); !ok {
 		err = ERR_INVALID_OUTPUT.asInt()
 		return
 	}
-	out.c.Shutdown()
-	delete(o.register, id)
+	locals.removeOutput(out)
+	out.m.Lock()
+	out.closed = true
+	if out.pool != nil {
+		out.pool.stop()
+		out.pool = nil
+	}
+	pending := make([]*request, 0, len(out.request_cache))
+	for _, r := range out.request_cache {
+		pending = append(pending, r)
+	}
+	out.request_cache = map[requestID]*request{}
+	out.m.Unlock()
+	out.shm.close()
+	out.requests.close()
+	for _, r := range out.requests.drain() {
+		pending = append(pending, r.(*request))
+	}
+	failLocal(pending)
+	out.s.close()
+	out.release()
 	return
 }
 
 func (o *outputRegister) requestAvailable(id C.int) (is bool, err C.int) {
 
-	o.m.Lock()
-	defer o.m.Unlock()
-	out, ok := o.register[id]
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+
+	is = !out.requests.empty()
+	return
+
+}
+
+func (o *outputRegister) waitRequest(id C.int, timeout C.int) (is bool, err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	is = out.s.wait(timeout, func() bool { return !out.requests.empty() })
+	return
+}
+
+func (o *outputRegister) fd(id C.int) (fd C.int, err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	fd, ok, err := out.s.fd(func() bool { return out.events() != 0 })
 	if !ok {
 		err = ERR_INVALID_OUTPUT.asInt()
+	}
+	return
+}
+
+func (o *outputRegister) setQueueLimit(id C.int, capacity int, policy C.int) (err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	if !validPolicy(policy) {
+		err = ERR_INVALID_QUEUE.asInt()
+		return
+	}
+	out.requests.setLimit(capacity, policy)
+	return
+}
+
+func (o *outputRegister) queueStats(id C.int) (length int, dropped uint64, rejected uint64, err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer out.release()
+	length, dropped, rejected = out.requests.stats()
+	return
+}
+
+// stats fills in the statistics of an output.
+func (o *outputRegister) stats(id C.int, dst *outputStats) (err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	out.stats.load(dst)
+	l, _, _ := out.requests.stats()
+	dst.requestsDepth = uint64(l)
+	out.m.RLock()
+	dst.requestCacheDepth = uint64(len(out.request_cache))
+	out.m.RUnlock()
+	return
+}
 
-	is = !out.requests.Empty()
+func (o *outputRegister) setRequestHandler(id C.int, fn unsafe.Pointer, userdata unsafe.Pointer) (err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	out.m.Lock()
+	defer out.m.Unlock()
+	if fn == nil {
+		out.handler = nil
+		return
+	}
+	out.handler = &requestHandler{
+		fn:       fn,
+		userdata: userdata,
+	}
 	return
+}
 
+// serve replaces the serve workers of an output. A nil handler only stops the
+// current workers.
+func (o *outputRegister) serve(id C.int, workers int, fn unsafe.Pointer, userdata unsafe.Pointer) (err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	var p *servePool
+	if fn != nil {
+		var ok bool
+		if p, ok = newServePool(out, workers, fn, userdata); !ok {
+			err = ERR_INVALID_OUTPUT.asInt()
+			return
+		}
+	}
+	out.m.Lock()
+	old := out.pool
+	out.pool = p
+	out.m.Unlock()
+	if old != nil {
+		old.stop()
+	}
+	return
 }
 
 func (o *outputRegister) nextRequestUUID(id C.int) (reqID uuid.UUID, err C.int) {
 
-	o.m.RLock()
-	defer o.m.RUnlock()
-	out, ok := o.register[id]
-	if !ok {
-		err = ERR_INVALID_OUTPUT.asInt()
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer out.release()
 
-	if out.requests.Empty() {
+	r, ok := out.requests.get()
+	if !ok {
 		err = ERR_NO_REQUEST_AVAILABLE.asInt()
 		return
 	}
+	req := r.(*request)
+	out.retrieved(req)
 	out.m.Lock()
 	defer out.m.Unlock()
-	req := out.requests.Get()
 	reqID = req.UUID
-	out.request_cache[reqID] = req
+	out.request_cache[requestKey(reqID)] = req
 	return
 }
 
-func (o *outputRegister) nextRequestFunction(id C.int, reqID uuid.UUID) (function string, err C.int) {
-	o.m.RLock()
-	defer o.m.RUnlock()
-	out, ok := o.register[id]
+func (o *outputRegister) takeRequest(id C.int) (req *request, err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	r, ok := out.requests.get()
 	if !ok {
-		err = ERR_INVALID_OUTPUT.asInt()
+		err = ERR_NO_REQUEST_AVAILABLE.asInt()
+		return
+	}
+	req = r.(*request)
+	out.retrieved(req)
+	out.m.Lock()
+	defer out.m.Unlock()
+	out.request_cache[requestKey(req.UUID)] = req
+	return
+}
+
+func (o *outputRegister) takeRequests(id C.int, max int) (reqs []*request, err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	rs := out.requests.take(max)
+	if len(rs) == 0 {
+		err = ERR_NO_REQUEST_AVAILABLE.asInt()
+		return
+	}
+	reqs = make([]*request, len(rs))
+	out.m.Lock()
+	defer out.m.Unlock()
+	for n, r := range rs {
+		reqs[n] = r.(*request)
+		out.retrieved(reqs[n])
+		out.request_cache[requestKey(reqs[n].UUID)] = reqs[n]
+	}
+	return
+}
+
+func (o *outputRegister) nextRequestFunction(id C.int, reqID requestID) (function string, err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer out.release()
 	out.m.RLock()
 	defer out.m.RUnlock()
 	req, ok := out.request_cache[reqID]
@@ -190,14 +513,12 @@ func (o *outputRegister) nextRequestFunction(id C.int, reqID uuid.UUID) (functio
 	return
 }
 
-func (o *outputRegister) nextRequestParameter(id C.int, reqID uuid.UUID) (params []byte, err C.int) {
-	o.m.RLock()
-	defer o.m.RUnlock()
-	out, ok := o.register[id]
-	if !ok {
-		err = ERR_INVALID_OUTPUT.asInt()
+func (o *outputRegister) nextRequestParameter(id C.int, reqID requestID) (params []byte, err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer out.release()
 	out.m.RLock()
 	defer out.m.RUnlock()
 	req, ok := out.request_cache[reqID]
@@ -209,14 +530,12 @@ func (o *outputRegister) nextRequestParameter(id C.int, reqID uuid.UUID) (params
 	return
 }
 
-func (o *outputRegister) reply(id C.int, reqID uuid.UUID, params []byte) (err C.int) {
-	o.m.RLock()
-	defer o.m.RUnlock()
-	out, ok := o.register[id]
-	if !ok {
-		err = ERR_INVALID_OUTPUT.asInt()
+func (o *outputRegister) reply(id C.int, reqID requestID, params []byte, borrowed bool) (err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer out.release()
 	out.m.Lock()
 	defer out.m.Unlock()
 	req, ok := out.request_cache[reqID]
@@ -224,46 +543,127 @@ func (o *outputRegister) reply(id C.int, reqID uuid.UUID, params []byte) (err C.
 		err = ERR_INVALID_REQUEST_ID.asInt()
 		return
 	}
-	out.c.Reply(req, params)
+	req.reply(out.c, params, borrowed)
+	out.stats.sent(params)
 	delete(out.request_cache, reqID)
 	return
 }
 
+func (o *outputRegister) replyBatch(id C.int, reqIDs []requestID, params [][]byte) (err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	reqs := make([]*request, 0, len(reqIDs))
+	replies := make([][]byte, 0, len(reqIDs))
+	out.m.Lock()
+	for n, reqID := range reqIDs {
+		req, ok := out.request_cache[reqID]
+		if !ok {
+			err = ERR_INVALID_REQUEST_ID.asInt()
+			continue
+		}
+		delete(out.request_cache, reqID)
+		reqs = append(reqs, req)
+		replies = append(replies, params[n])
+	}
+	out.m.Unlock()
+	for n, req := range reqs {
+		req.reply(out.c, replies[n], false)
+		out.stats.sent(replies[n])
+	}
+	return
+}
+
 func (o *outputRegister) emit(id C.int, function string, in_params []byte, out_params []byte) (err C.int) {
-	o.m.RLock()
-	defer o.m.RUnlock()
-	out, ok := o.register[id]
-	if !ok {
-		err = ERR_INVALID_OUTPUT.asInt()
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	err = out.emit(function, in_params, out_params)
+	return
+}
+
+func (o *outputRegister) emitByID(id C.int, functionID C.int, in_params []byte, out_params []byte) (err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	function, err := out.names.function(functionID)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	err = out.emit(function, in_params, out_params)
+	return
+}
+
+func (out *output) emit(function string, in_params []byte, out_params []byte) (err C.int) {
 	ferr := out.c.Emit(function, in_params, out_params)
 	if ferr != nil {
 		err = ERR_INVALID_FUNCTION.asInt()
 		return
 	}
+	out.stats.sent(out_params)
 	return
 }
 
 func (o *outputRegister) setProperty(id C.int, property string, value []byte) (err C.int) {
-	o.m.RLock()
-	defer o.m.RUnlock()
-	out, ok := o.register[id]
-	if !ok {
-		err = ERR_INVALID_OUTPUT.asInt()
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	err = out.setProperty(property, value)
+	return
+}
+
+func (o *outputRegister) setPropertyByID(id C.int, propertyID C.int, value []byte) (err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	property, err := out.names.property(propertyID)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	err = out.setProperty(property, value)
+	return
+}
+
+func (out *output) setProperty(property string, value []byte) (err C.int) {
 	perr := out.c.SetProperty(property, value)
 	if perr != nil {
 		err = ERR_INVALID_PROPERTY.asInt()
+	}
+	return
+}
+
+func (o *outputRegister) functionID(id C.int, function string) (functionID C.int, err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
 		return
 	}
+	defer out.release()
+	functionID, err = out.names.functionID(function)
+	return
+}
+
+func (o *outputRegister) propertyID(id C.int, property string) (propertyID C.int, err C.int) {
+	out, err := o.get(id)
+	if err != NO_ERR.asInt() {
+		return
+	}
+	defer out.release()
+	propertyID, err = out.names.propertyID(property)
 	return
 }
 
 var outputs = outputRegister{
-	m:        &sync.RWMutex{},
-	register: map[C.int]*output{},
+	handles: newHandleTable(),
 }
 
 //export new_output
@@ -305,6 +705,25 @@ func output_interface(o C.int, iface_p **C.char, iface_size *C.int) C.int {
 	return err
 }
 
+//export output_fd
+func output_fd(o C.int, fd_p *C.int) C.int {
+	fd, err := outputs.fd(o)
+	if err == NO_ERR.asInt() {
+		*fd_p = fd
+	}
+	return err
+}
+
+//export output_set_request_handler
+func output_set_request_handler(o C.int, handler unsafe.Pointer, userdata unsafe.Pointer) C.int {
+	return outputs.setRequestHandler(o, handler, userdata)
+}
+
+//export output_serve
+func output_serve(o C.int, nthreads C.int, handler unsafe.Pointer, userdata unsafe.Pointer) C.int {
+	return outputs.serve(o, int(nthreads), handler, userdata)
+}
+
 //export output_request_id
 func output_request_id(o C.int, req_id **C.char, req_id_size *C.int) C.int {
 	reqID, err := outputs.nextRequestUUID(o)
@@ -315,6 +734,91 @@ func output_request_id(o C.int, req_id **C.char, req_id_size *C.int) C.int {
 	return err
 }
 
+//export output_request_id_bin
+func output_request_id_bin(o C.int, req_id unsafe.Pointer) C.int {
+	reqID, err := outputs.nextRequestUUID(o)
+	if err == NO_ERR.asInt() {
+		putRequestID(req_id, requestKey(reqID))
+	}
+	return err
+}
+
+//export output_request_take
+func output_request_take(o C.int, req_id **C.char, function **C.char, params *unsafe.Pointer, params_size *C.int) C.int {
+	req, err := outputs.takeRequest(o)
+	if err == NO_ERR.asInt() {
+		p := req.Parameter()
+		fields := packFields([]byte(req.UUID), []byte(req.Function), p)
+		*req_id = (*C.char)(fields[0])
+		*function = (*C.char)(fields[1])
+		*params = fields[2]
+		*params_size = C.int(len(p))
+	}
+	return err
+}
+
+//export output_queue_set
+func output_queue_set(o C.int, capacity C.int, policy C.int) C.int {
+	return outputs.setQueueLimit(o, int(capacity), policy)
+}
+
+//export output_queue_stats
+func output_queue_stats(o C.int, length *C.int, dropped *C.ulonglong, rejected *C.ulonglong) C.int {
+	l, d, r, err := outputs.queueStats(o)
+	if err == NO_ERR.asInt() {
+		*length = C.int(l)
+		*dropped = C.ulonglong(d)
+		*rejected = C.ulonglong(r)
+	}
+	return err
+}
+
+//export output_stats
+func output_stats(o C.int, stats unsafe.Pointer) C.int {
+	return outputs.stats(o, (*outputStats)(stats))
+}
+
+//export output_request_take_batch
+func output_request_take_batch(o C.int, max C.int, req_ids **C.char, functions **C.char, offsets *C.int, params *unsafe.Pointer, n *C.int) C.int {
+	*n = 0
+	reqs, err := outputs.takeRequests(o, int(max))
+	if err != NO_ERR.asInt() {
+		return err
+	}
+	ps := make([][]byte, len(reqs))
+	size := 0
+	for k, req := range reqs {
+		ps[k] = req.Parameter()
+		size += len(ps[k]) + len(req.UUID) + len(req.Function) + 2
+	}
+	// The parameters are packed first, followed by the zero terminated
+	// UUIDs and function names.
+	base := C.malloc(C.size_t(size))
+	buf := unsafe.Slice((*byte)(base), size)
+	ids := unsafe.Slice(req_ids, len(reqs))
+	funs := unsafe.Slice(functions, len(reqs))
+	offs := unsafe.Slice(offsets, len(reqs)+1)
+	pos := 0
+	for k, p := range ps {
+		offs[k] = C.int(pos)
+		pos += copy(buf[pos:], p)
+	}
+	offs[len(reqs)] = C.int(pos)
+	for k, req := range reqs {
+		ids[k] = (*C.char)(unsafe.Pointer(&buf[pos]))
+		pos += copy(buf[pos:], req.UUID)
+		buf[pos] = 0
+		pos++
+		funs[k] = (*C.char)(unsafe.Pointer(&buf[pos]))
+		pos += copy(buf[pos:], req.Function)
+		buf[pos] = 0
+		pos++
+	}
+	*params = base
+	*n = C.int(len(reqs))
+	return err
+}
+
 //export output_request_available
 func output_request_available(o C.int, is_p *C.int) C.int {
 	is, err := outputs.requestAvailable(o)
@@ -322,9 +826,16 @@ func output_request_available(o C.int, is_p *C.int) C.int {
 	return err
 }
 
+//export output_request_wait
+func output_request_wait(o C.int, timeout C.int, is_p *C.int) C.int {
+	is, err := outputs.waitRequest(o, timeout)
+	boolToIntPtr(is, is_p)
+	return err
+}
+
 //export output_request_function
 func output_request_function(o C.int, req_id *C.char, function **C.char, function_size *C.int) C.int {
-	reqID := uuid.UUID(C.GoString(req_id))
+	reqID := cRequestID(req_id)
 	fun, err := outputs.nextRequestFunction(o, reqID)
 	if err == NO_ERR.asInt() {
 		*function = C.CString(fun)
@@ -333,9 +844,19 @@ func output_request_function(o C.int, req_id *C.char, function **C.char, functio
 	return err
 }
 
+//export output_request_function_bin
+func output_request_function_bin(o C.int, req_id unsafe.Pointer, function **C.char, function_size *C.int) C.int {
+	fun, err := outputs.nextRequestFunction(o, binRequestID(req_id))
+	if err == NO_ERR.asInt() {
+		*function = C.CString(fun)
+		*function_size = C.int(len(fun))
+	}
+	return err
+}
+
 //export output_request_params
 func output_request_params(o C.int, req_id *C.char, params *unsafe.Pointer, params_size *C.int) C.int {
-	reqID := uuid.UUID(C.GoString(req_id))
+	reqID := cRequestID(req_id)
 	p, err := outputs.nextRequestParameter(o, reqID)
 	if err == NO_ERR.asInt() {
 		*params = unsafe.Pointer(C.CBytes(p))
@@ -344,11 +865,78 @@ func output_request_params(o C.int, req_id *C.char, params *unsafe.Pointer, para
 	return err
 }
 
+//export output_request_params_into
+func output_request_params_into(o C.int, req_id *C.char, buf unsafe.Pointer, capacity C.int, params_size *C.int) C.int {
+	reqID := cRequestID(req_id)
+	p, err := outputs.nextRequestParameter(o, reqID)
+	if err == NO_ERR.asInt() {
+		err = copyInto(p, buf, capacity, params_size)
+	}
+	return err
+}
+
+//export output_request_params_bin
+func output_request_params_bin(o C.int, req_id unsafe.Pointer, params *unsafe.Pointer, params_size *C.int) C.int {
+	p, err := outputs.nextRequestParameter(o, binRequestID(req_id))
+	if err == NO_ERR.asInt() {
+		*params = unsafe.Pointer(C.CBytes(p))
+		*params_size = C.int(len(p))
+	}
+	return err
+}
+
 //export output_reply
 func output_reply(o C.int, req_id *C.char, params unsafe.Pointer, params_size C.int) C.int {
-	reqID := uuid.UUID(C.GoString(req_id))
+	reqID := cRequestID(req_id)
 	parameter := getParams(params, params_size)
-	err := outputs.reply(o, reqID, parameter)
+	err := outputs.reply(o, reqID, parameter, false)
+	return err
+}
+
+//export output_reply_nocopy
+func output_reply_nocopy(o C.int, req_id *C.char, params unsafe.Pointer, params_size C.int, release unsafe.Pointer, userdata unsafe.Pointer) C.int {
+	reqID := cRequestID(req_id)
+	parameter := borrowParams(params, params_size)
+	err := outputs.reply(o, reqID, parameter, true)
+	// request.reply keeps no reference to parameter once it returns.
+	callReleaseHandler(release, params, userdata)
+	return err
+}
+
+//export output_reply_bin
+func output_reply_bin(o C.int, req_id unsafe.Pointer, params unsafe.Pointer, params_size C.int) C.int {
+	parameter := getParams(params, params_size)
+	return outputs.reply(o, binRequestID(req_id), parameter, false)
+}
+
+//export output_reply_batch
+func output_reply_batch(o C.int, n C.int, req_ids **C.char, params unsafe.Pointer, offsets *C.int) C.int {
+	ids, replies, err := getBatch(n, req_ids, params, offsets)
+	if err != NO_ERR.asInt() || n == 0 {
+		return err
+	}
+	reqIDs := make([]requestID, n)
+	for k, id := range ids {
+		reqIDs[k], _ = toRequestID(uuid.UUID(id))
+	}
+	return outputs.replyBatch(o, reqIDs, replies)
+}
+
+//export output_function_id
+func output_function_id(o C.int, function *C.char, id *C.int) C.int {
+	fid, err := outputs.functionID(o, C.GoString(function))
+	if err == NO_ERR.asInt() {
+		*id = fid
+	}
+	return err
+}
+
+//export output_property_id
+func output_property_id(o C.int, property *C.char, id *C.int) C.int {
+	pid, err := outputs.propertyID(o, C.GoString(property))
+	if err == NO_ERR.asInt() {
+		*id = pid
+	}
 	return err
 }
 
@@ -361,6 +949,14 @@ func output_emit(o C.int, function *C.char, in_params unsafe.Pointer, in_params_
 	return err
 }
 
+//export output_emit_id
+func output_emit_id(o C.int, function C.int, in_params unsafe.Pointer, in_params_size C.int, out_params unsafe.Pointer, out_params_size C.int) C.int {
+	inParams := getParams(in_params, in_params_size)
+	outParams := getParams(out_params, out_params_size)
+	err := outputs.emitByID(o, function, inParams, outParams)
+	return err
+}
+
 //export output_property_set
 func output_property_set(o C.int, property *C.char, value_p unsafe.Pointer, value_size C.int) C.int {
 	prop := C.GoString(property)
@@ -368,3 +964,10 @@ func output_property_set(o C.int, property *C.char, value_p unsafe.Pointer, valu
 	err := outputs.setProperty(o, prop, value)
 	return err
 }
+
+//export output_property_set_id
+func output_property_set_id(o C.int, property C.int, value_p unsafe.Pointer, value_size C.int) C.int {
+	value := getParams(value_p, value_size)
+	err := outputs.setPropertyByID(o, property, value)
+	return err
+}
@@ -0,0 +1,147 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import "C"
+
+import (
+	"sync/atomic"
+	"unsafe"
+)
+
+// Handle kinds and ready flags of tvio_poll, they mirror the TVIO_POLL_*
+// defines in thingiverseio.h.
+const (
+	POLL_INPUT C.int = iota
+	POLL_OUTPUT
+)
+
+const (
+	POLL_REQUEST C.int = 1 << iota
+	POLL_RESULT
+	POLL_LISTEN
+	POLL_CHANGE
+	POLL_INVALID
+)
+
+// pollItem mirrors tvio_poll_item.
+type pollItem struct {
+	handle C.int
+	kind   C.int
+	ready  C.int
+}
+
+type pollable interface {
+	events() C.int
+	signal() *signal
+	release()
+}
+
+func (in *input) events() (ready C.int) {
+	if atomic.LoadInt32(&in.resultsReady) > 0 || in.callAllReady() {
+		ready |= POLL_RESULT
+	}
+	if !in.listen.empty() {
+		ready |= POLL_LISTEN
+	}
+	if !in.propertyChanges.empty() {
+		ready |= POLL_CHANGE
+	}
+	return
+}
+
+func (in *input) signal() *signal {
+	return in.s
+}
+
+func (in *input) callAllReady() bool {
+	in.m.RLock()
+	defer in.m.RUnlock()
+	for _, ca := range in.callall {
+		if !ca.results.empty() {
+			return true
+		}
+	}
+	return false
+}
+
+func (out *output) events() (ready C.int) {
+	if !out.requests.empty() {
+		ready |= POLL_REQUEST
+	}
+	return
+}
+
+func (out *output) signal() *signal {
+	return out.s
+}
+
+func getPollable(handle C.int, kind C.int) pollable {
+	switch kind {
+	case POLL_INPUT:
+		if in, err := inputs.get(handle); err == NO_ERR.asInt() {
+			return in
+		}
+	case POLL_OUTPUT:
+		if out, err := outputs.get(handle); err == NO_ERR.asInt() {
+			return out
+		}
+	}
+	return nil
+}
+
+//export poll_handles
+func poll_handles(items unsafe.Pointer, n C.int, timeout C.int, n_ready *C.int) C.int {
+	*n_ready = 0
+	if n <= 0 {
+		return NO_ERR.asInt()
+	}
+	its := unsafe.Slice((*pollItem)(items), n)
+	hs := make([]pollable, n)
+	w := newSignal()
+	for k := range its {
+		hs[k] = getPollable(its[k].handle, its[k].kind)
+		if hs[k] != nil {
+			hs[k].signal().watch(w)
+		}
+	}
+	defer func() {
+		for _, h := range hs {
+			if h != nil {
+				h.signal().unwatch(w)
+				h.release()
+			}
+		}
+	}()
+	w.wait(timeout, func() bool {
+		count := C.int(0)
+		for k, h := range hs {
+			if h == nil || h.signal().isClosed() {
+				its[k].ready = POLL_INVALID
+			} else {
+				its[k].ready = h.events()
+			}
+			if its[k].ready != 0 {
+				count++
+			}
+		}
+		*n_ready = count
+		return count > 0
+	})
+	return NO_ERR.asInt()
+}
@@ -0,0 +1,193 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import "C"
+
+import "sync"
+
+// Overflow policies of bounded queues, they mirror the TVIO_QUEUE_* defines
+// in thingiverseio.h.
+const (
+	QUEUE_BLOCK C.int = iota
+	QUEUE_DROP_OLDEST
+	QUEUE_DROP_NEWEST
+	QUEUE_REJECT
+)
+
+func validPolicy(policy C.int) bool {
+	return policy >= QUEUE_BLOCK && policy <= QUEUE_REJECT
+}
+
+// dropper is implemented by items which have to know when a bounded queue
+// drops them after they were added. Items which are refused right away are
+// reported by add instead.
+type dropper interface {
+	drop()
+}
+
+func notifyDropped(d interface{}) {
+	if dr, ok := d.(dropper); ok {
+		dr.drop()
+	}
+}
+
+// queue buffers data arriving from the core until the host retrieves it.
+// Every addition notifies the signal of the owning handle. A queue is
+// unbounded unless a capacity is set, the policy then decides what happens
+// to additions while it is full.
+type queue struct {
+	m        *sync.Mutex
+	space    *sync.Cond
+	items    []interface{}
+	s        *signal
+	capacity int
+	policy   C.int
+	dropped  uint64
+	rejected uint64
+	closed   bool
+}
+
+func newQueue(s *signal) *queue {
+	m := &sync.Mutex{}
+	return &queue{
+		m:     m,
+		space: sync.NewCond(m),
+		s:     s,
+	}
+}
+
+// add appends d. It returns false if d was dropped or rejected because the
+// queue is full, or because it is closed.
+func (q *queue) add(d interface{}) bool {
+	q.m.Lock()
+	if q.closed {
+		q.m.Unlock()
+		return false
+	}
+	for q.capacity > 0 && len(q.items) >= q.capacity && !q.closed {
+		switch q.policy {
+		case QUEUE_BLOCK:
+			q.space.Wait()
+		case QUEUE_DROP_OLDEST:
+			notifyDropped(q.items[0])
+			q.items[0] = nil
+			q.items = q.items[1:]
+			q.dropped++
+		case QUEUE_DROP_NEWEST:
+			q.dropped++
+			q.m.Unlock()
+			return false
+		default:
+			q.rejected++
+			q.m.Unlock()
+			return false
+		}
+	}
+	if q.closed {
+		q.m.Unlock()
+		return false
+	}
+	q.items = append(q.items, d)
+	q.m.Unlock()
+	q.s.notify()
+	return true
+}
+
+// setLimit bounds the queue to capacity items, 0 removes the bound. Items
+// beyond a lowered capacity stay queued, QUEUE_DROP_OLDEST drops them with the
+// next addition.
+func (q *queue) setLimit(capacity int, policy C.int) {
+	q.m.Lock()
+	defer q.m.Unlock()
+	q.capacity = capacity
+	q.policy = policy
+	q.space.Broadcast()
+}
+
+func (q *queue) stats() (length int, dropped uint64, rejected uint64) {
+	q.m.Lock()
+	defer q.m.Unlock()
+	return len(q.items), q.dropped, q.rejected
+}
+
+// close releases blocked producers for good and rejects further additions.
+func (q *queue) close() {
+	q.m.Lock()
+	defer q.m.Unlock()
+	q.closed = true
+	q.space.Broadcast()
+}
+
+// drain removes and returns all items.
+func (q *queue) drain() (d []interface{}) {
+	q.m.Lock()
+	defer q.m.Unlock()
+	d, q.items = q.items, nil
+	q.space.Broadcast()
+	return
+}
+
+func (q *queue) empty() bool {
+	q.m.Lock()
+	defer q.m.Unlock()
+	return len(q.items) == 0
+}
+
+func (q *queue) preview() (d interface{}, ok bool) {
+	q.m.Lock()
+	defer q.m.Unlock()
+	if len(q.items) == 0 {
+		return
+	}
+	return q.items[0], true
+}
+
+func (q *queue) get() (d interface{}, ok bool) {
+	q.m.Lock()
+	defer q.m.Unlock()
+	if len(q.items) == 0 {
+		return
+	}
+	d, ok = q.items[0], true
+	q.items[0] = nil
+	q.items = q.items[1:]
+	q.space.Broadcast()
+	return
+}
+
+// take removes and returns up to max items.
+func (q *queue) take(max int) (d []interface{}) {
+	q.m.Lock()
+	defer q.m.Unlock()
+	n := len(q.items)
+	if n > max {
+		n = max
+	}
+	if n < 0 {
+		n = 0
+	}
+	d = make([]interface{}, n)
+	copy(d, q.items)
+	for k := 0; k < n; k++ {
+		q.items[k] = nil
+	}
+	q.items = q.items[n:]
+	q.space.Broadcast()
+	return
+}
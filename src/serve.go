@@ -0,0 +1,190 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import "C"
+
+import (
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"time"
+	"unsafe"
+)
+
+// workDeque holds the requests of one serve worker. The owner takes requests
+// from the front, so they are served in arrival order, while idle workers
+// steal from the back. Every deque has its own lock, which is only contended
+// by a steal.
+type workDeque struct {
+	m     sync.Mutex
+	items []*request
+	head  int
+	_     [64]byte // keeps neighbouring deques off the same cache line
+}
+
+func (d *workDeque) push(r *request) {
+	d.m.Lock()
+	d.items = append(d.items, r)
+	d.m.Unlock()
+}
+
+func (d *workDeque) pop() (r *request) {
+	d.m.Lock()
+	if d.head < len(d.items) {
+		r = d.items[d.head]
+		d.items[d.head] = nil
+		d.head++
+		d.compact()
+	}
+	d.m.Unlock()
+	return
+}
+
+func (d *workDeque) steal() (r *request) {
+	d.m.Lock()
+	if n := len(d.items); n > d.head {
+		r = d.items[n-1]
+		d.items[n-1] = nil
+		d.items = d.items[:n-1]
+		d.compact()
+	}
+	d.m.Unlock()
+	return
+}
+
+// compact reuses the space of taken requests, so a deque which never runs
+// empty does not grow.
+func (d *workDeque) compact() {
+	switch {
+	case d.head == len(d.items):
+		d.items = d.items[:0]
+		d.head = 0
+	case d.head > 32 && 2*d.head > len(d.items):
+		n := copy(d.items, d.items[d.head:])
+		for i := n; i < len(d.items); i++ {
+			d.items[i] = nil
+		}
+		d.items = d.items[:n]
+		d.head = 0
+	}
+}
+
+// servePool serves the requests of an output on a fixed number of workers.
+// Incoming requests are spread round robin across the worker deques, a
+// worker whose deque runs empty steals from the others. Workers reply
+// directly to the request they hold, so neither the output lock nor the
+// request cache is touched after dispatch.
+type servePool struct {
+	out      *output
+	handler  unsafe.Pointer
+	userdata unsafe.Pointer
+	deques   []workDeque
+	next     uint32
+	wake     chan struct{}
+	done     chan struct{}
+	wg       sync.WaitGroup
+}
+
+// newServePool starts the workers. The pool holds a reference to the output
+// until the last worker has returned.
+func newServePool(out *output, workers int, handler unsafe.Pointer, userdata unsafe.Pointer) (p *servePool, ok bool) {
+	if !out.acquire() {
+		return
+	}
+	if workers <= 0 {
+		workers = runtime.NumCPU()
+	}
+	p = &servePool{
+		out:      out,
+		handler:  handler,
+		userdata: userdata,
+		deques:   make([]workDeque, workers),
+		wake:     make(chan struct{}, workers),
+		done:     make(chan struct{}),
+	}
+	p.wg.Add(workers)
+	for w := 0; w < workers; w++ {
+		go p.work(w)
+	}
+	go func() {
+		p.wg.Wait()
+		out.release()
+	}()
+	ok = true
+	return
+}
+
+// add queues a request and wakes an idle worker. It must not be called after
+// stop.
+func (p *servePool) add(r *request) {
+	n := atomic.AddUint32(&p.next, 1)
+	p.deques[n%uint32(len(p.deques))].push(r)
+	select {
+	case p.wake <- struct{}{}:
+	default:
+	}
+}
+
+// stop lets the workers serve the remaining requests and return. It does not
+// wait for them, so it may be called from a handler.
+func (p *servePool) stop() {
+	close(p.done)
+}
+
+func (p *servePool) take(worker int) *request {
+	if r := p.deques[worker].pop(); r != nil {
+		return r
+	}
+	for n := 1; n < len(p.deques); n++ {
+		if r := p.deques[(worker+n)%len(p.deques)].steal(); r != nil {
+			return r
+		}
+	}
+	return nil
+}
+
+func (p *servePool) work(worker int) {
+	defer p.wg.Done()
+	for {
+		if r := p.take(worker); r != nil {
+			p.serve(worker, r)
+			continue
+		}
+		select {
+		case <-p.wake:
+		case <-p.done:
+			// Requests added before stop are visible now.
+			for r := p.take(worker); r != nil; r = p.take(worker) {
+				p.serve(worker, r)
+			}
+			return
+		}
+	}
+}
+
+func (p *servePool) serve(worker int, r *request) {
+	p.out.stats.queueTime.record(time.Since(r.arrived))
+	function, err := p.out.names.functionID(r.Function)
+	if err != NO_ERR.asInt() {
+		function = -1
+	}
+	reply := callServeHandler(p.handler, p.userdata, p.out.id, C.int(worker), function, r)
+	r.reply(p.out.c, reply, false)
+	p.out.stats.sent(reply)
+}
@@ -0,0 +1,652 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import (
+	"encoding/binary"
+	"hash/fnv"
+	"os"
+	"path/filepath"
+	"runtime"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"time"
+	"unsafe"
+
+	"github.com/ThingiverseIO/uuid"
+)
+
+// Same host transport for CALLs. An output announces itself in shmDir. An
+// input with the same interface connects by creating two memory mapped rings,
+// one carrying requests and one carrying results. Frames are copied in and out
+// of the rings without syscalls; an idle side yields, sleeps with growing
+// intervals up to shmMaxBackoff and then blocks on a futex in the ring header
+// until the peer makes progress. Outputs learn about new connections through
+// inotify.
+//
+// Enabled by setting TVIO_SHM=1.
+
+const (
+	shmDir          = "/dev/shm/tvio"
+	shmRingSize     = 1 << 20
+	shmHeaderSize   = 4096
+	shmSpins        = 128
+	shmMaxBackoff   = 500 * time.Microsecond
+	shmWaitTimeout  = 100 * time.Millisecond
+	shmScanInterval = 10 * time.Millisecond
+	shmDialInterval = time.Second
+)
+
+var shmEnabled = os.Getenv("TVIO_SHM") == "1"
+
+func shmIfaceDir(iface string) string {
+	h := fnv.New64a()
+	h.Write([]byte(iface))
+	return filepath.Join(shmDir, strconv.FormatUint(h.Sum64(), 16))
+}
+
+func processAlive(pid int) bool {
+	if pid <= 0 {
+		return true
+	}
+	return syscall.Kill(pid, 0) != syscall.ESRCH
+}
+
+// writeFileAtomic writes a small file under a temporary name and renames it,
+// so readers never see partial content.
+func writeFileAtomic(path string, data []byte) error {
+	tmp := path + ".tmp"
+	if err := os.WriteFile(tmp, data, 0600); err != nil {
+		return err
+	}
+	return os.Rename(tmp, path)
+}
+
+func readPid(path string) int {
+	b, err := os.ReadFile(path)
+	if err != nil {
+		return 0
+	}
+	pid, _ := strconv.Atoi(strings.TrimSpace(string(b)))
+	return pid
+}
+
+// futexWait blocks while *addr is v, at most for timeout. The futex is not
+// private, so it works across processes mapping the same file.
+func futexWait(addr *uint32, v uint32, timeout time.Duration) {
+	ts := syscall.NsecToTimespec(int64(timeout))
+	syscall.Syscall6(syscall.SYS_FUTEX, uintptr(unsafe.Pointer(addr)), 0, uintptr(v), uintptr(unsafe.Pointer(&ts)), 0, 0)
+}
+
+func futexWake(addr *uint32) {
+	syscall.Syscall6(syscall.SYS_FUTEX, uintptr(unsafe.Pointer(addr)), 1, uintptr(^uint32(0)>>1), 0, 0, 0)
+}
+
+// shmRing is a single producer, single consumer byte ring in a shared file
+// mapping. head and tail are free running counters on separate cache lines.
+// A side which waits for the peer registers in waiters and sleeps on wake,
+// which the peer bumps whenever it moves head or tail.
+type shmRing struct {
+	mem     []byte
+	data    []byte
+	head    *uint64
+	tail    *uint64
+	closed  *uint32
+	wake    *uint32
+	waiters *uint32
+	peer    int
+}
+
+func openShmRing(path string, create bool, peer int) (r *shmRing, err error) {
+	flags := os.O_RDWR
+	if create {
+		flags |= os.O_CREATE | os.O_EXCL
+	}
+	f, err := os.OpenFile(path, flags, 0600)
+	if err != nil {
+		return
+	}
+	defer f.Close()
+	size := int64(shmHeaderSize + shmRingSize)
+	if create {
+		err = f.Truncate(size)
+	} else if fi, serr := f.Stat(); serr != nil || fi.Size() != size {
+		err = syscall.EINVAL
+	}
+	if err != nil {
+		return
+	}
+	mem, err := syscall.Mmap(int(f.Fd()), 0, int(size), syscall.PROT_READ|syscall.PROT_WRITE, syscall.MAP_SHARED)
+	if err != nil {
+		return
+	}
+	r = &shmRing{
+		mem:     mem,
+		data:    mem[shmHeaderSize:],
+		head:    (*uint64)(unsafe.Pointer(&mem[0])),
+		tail:    (*uint64)(unsafe.Pointer(&mem[64])),
+		closed:  (*uint32)(unsafe.Pointer(&mem[128])),
+		wake:    (*uint32)(unsafe.Pointer(&mem[192])),
+		waiters: (*uint32)(unsafe.Pointer(&mem[256])),
+		peer:    peer,
+	}
+	return
+}
+
+func (r *shmRing) close() {
+	atomic.StoreUint32(r.closed, 1)
+	atomic.AddUint32(r.wake, 1)
+	futexWake(r.wake)
+}
+
+// signal wakes a peer blocked in backoff.
+func (r *shmRing) signal() {
+	if atomic.LoadUint32(r.waiters) != 0 {
+		atomic.AddUint32(r.wake, 1)
+		futexWake(r.wake)
+	}
+}
+
+// backoff waits until the peer moves the counter c away from v. It fails
+// once the ring is closed or the peer process is gone.
+func (r *shmRing) backoff(spins *int, c *uint64, v uint64) bool {
+	if atomic.LoadUint32(r.closed) != 0 {
+		return false
+	}
+	*spins++
+	if *spins < shmSpins {
+		runtime.Gosched()
+		return true
+	}
+	if *spins%shmSpins == 0 && !processAlive(r.peer) {
+		r.close()
+		return false
+	}
+	d := time.Duration(*spins-shmSpins+1) * time.Microsecond
+	if d < shmMaxBackoff {
+		time.Sleep(d)
+		return true
+	}
+	// The peer is idle. Registering before checking c again makes sure
+	// either the check sees its progress or it sees the waiter and bumps
+	// wake, which makes the futex return right away.
+	w := atomic.LoadUint32(r.wake)
+	atomic.AddUint32(r.waiters, 1)
+	if atomic.LoadUint64(c) == v && atomic.LoadUint32(r.closed) == 0 {
+		futexWait(r.wake, w, shmWaitTimeout)
+	}
+	atomic.AddUint32(r.waiters, ^uint32(0))
+	if atomic.LoadUint64(c) == v && !processAlive(r.peer) {
+		r.close()
+		return false
+	}
+	return true
+}
+
+// write copies p into the ring, waiting whenever it is full.
+func (r *shmRing) write(p []byte) bool {
+	h := atomic.LoadUint64(r.head)
+	spins := 0
+	for len(p) > 0 {
+		free := uint64(len(r.data)) - (h - atomic.LoadUint64(r.tail))
+		if free == 0 {
+			if !r.backoff(&spins, r.tail, h-uint64(len(r.data))) {
+				return false
+			}
+			continue
+		}
+		spins = 0
+		n := uint64(len(p))
+		if n > free {
+			n = free
+		}
+		off := h & uint64(len(r.data)-1)
+		k := uint64(copy(r.data[off:], p[:n]))
+		copy(r.data, p[k:n])
+		h += n
+		atomic.StoreUint64(r.head, h)
+		r.signal()
+		p = p[n:]
+	}
+	return true
+}
+
+// read fills p from the ring, waiting whenever it is empty.
+func (r *shmRing) read(p []byte) bool {
+	t := atomic.LoadUint64(r.tail)
+	spins := 0
+	for len(p) > 0 {
+		avail := atomic.LoadUint64(r.head) - t
+		if avail == 0 {
+			if !r.backoff(&spins, r.head, t) {
+				return false
+			}
+			continue
+		}
+		spins = 0
+		n := uint64(len(p))
+		if n > avail {
+			n = avail
+		}
+		off := t & uint64(len(r.data)-1)
+		k := uint64(copy(p[:n], r.data[off:]))
+		copy(p[k:n], r.data)
+		t += n
+		atomic.StoreUint64(r.tail, t)
+		r.signal()
+		p = p[n:]
+	}
+	return true
+}
+
+// shmConn is one connection between an input and an output. Frames are
+// written by any goroutine under m and read by a single serving goroutine,
+// which also unmaps the rings once the connection is closed.
+type shmConn struct {
+	m      *sync.Mutex
+	life   *sync.Mutex
+	mapped bool
+	rx     *shmRing
+	tx     *shmRing
+	paths  []string
+}
+
+func newShmConn(rx, tx *shmRing, paths ...string) *shmConn {
+	return &shmConn{
+		m:      &sync.Mutex{},
+		life:   &sync.Mutex{},
+		mapped: true,
+		rx:     rx,
+		tx:     tx,
+		paths:  paths,
+	}
+}
+
+// shmFailed marks a result frame which carries an error code as little endian
+// int32 instead of result parameters. Result frames otherwise have no
+// function.
+const shmFailed = "!"
+
+// send writes a frame: id length (1 byte), function length (2 bytes),
+// parameter length (4 bytes), followed by the three fields.
+func (c *shmConn) send(id uuid.UUID, function string, params []byte) bool {
+	if len(id) > 0xff || len(function) > 0xffff || int64(len(params)) > 0xffffffff {
+		return false
+	}
+	var hdr [7]byte
+	hdr[0] = byte(len(id))
+	binary.LittleEndian.PutUint16(hdr[1:], uint16(len(function)))
+	binary.LittleEndian.PutUint32(hdr[3:], uint32(len(params)))
+	c.m.Lock()
+	defer c.m.Unlock()
+	if !c.mapped {
+		return false
+	}
+	return c.tx.write(hdr[:]) && c.tx.write([]byte(id)) && c.tx.write([]byte(function)) && c.tx.write(params)
+}
+
+// sendError answers the request id with an error code.
+func (c *shmConn) sendError(id uuid.UUID, code int32) bool {
+	var p [4]byte
+	binary.LittleEndian.PutUint32(p[:], uint32(code))
+	return c.send(id, shmFailed, p[:])
+}
+
+// serve reads frames until the connection is closed.
+func (c *shmConn) serve(handle func(id uuid.UUID, function string, params []byte)) {
+	defer c.unmap()
+	var hdr [7]byte
+	for c.rx.read(hdr[:]) {
+		n := int(hdr[0])
+		m := n + int(binary.LittleEndian.Uint16(hdr[1:]))
+		b := make([]byte, m+int(binary.LittleEndian.Uint32(hdr[3:])))
+		if !c.rx.read(b) {
+			return
+		}
+		handle(uuid.UUID(b[:n]), string(b[n:m]), b[m:])
+	}
+}
+
+func (c *shmConn) isClosed() bool {
+	c.life.Lock()
+	defer c.life.Unlock()
+	return !c.mapped || atomic.LoadUint32(c.rx.closed) != 0
+}
+
+func (c *shmConn) close() {
+	c.life.Lock()
+	defer c.life.Unlock()
+	if c.mapped {
+		c.rx.close()
+		c.tx.close()
+	}
+}
+
+func (c *shmConn) unmap() {
+	c.close()
+	c.m.Lock()
+	defer c.m.Unlock()
+	c.life.Lock()
+	defer c.life.Unlock()
+	c.mapped = false
+	syscall.Munmap(c.rx.mem)
+	syscall.Munmap(c.tx.mem)
+	for _, p := range c.paths {
+		os.Remove(p)
+	}
+}
+
+// shmClient is the input side. It connects to the first live output of its
+// interface and retries at most every shmDialInterval. Once a connection is
+// gone, lost is called with it, so CALLs still waiting for it can fail.
+type shmClient struct {
+	m        *sync.Mutex
+	dir      string
+	self     string
+	complete func(id uuid.UUID, params []byte)
+	fail     func(id uuid.UUID, code int32)
+	lost     func(c *shmConn)
+	c        *shmConn
+	last     time.Time
+	closed   bool
+}
+
+func newShmClient(iface string, self uuid.UUID, complete func(uuid.UUID, []byte), fail func(uuid.UUID, int32), lost func(*shmConn)) *shmClient {
+	if !shmEnabled {
+		return nil
+	}
+	return &shmClient{
+		m:        &sync.Mutex{},
+		dir:      shmIfaceDir(iface),
+		self:     string(self),
+		complete: complete,
+		fail:     fail,
+		lost:     lost,
+	}
+}
+
+// conn returns the current connection, or nil if there is no local output.
+func (s *shmClient) conn() *shmConn {
+	if s == nil {
+		return nil
+	}
+	s.m.Lock()
+	defer s.m.Unlock()
+	if s.c != nil && !s.c.isClosed() {
+		return s.c
+	}
+	s.c = nil
+	if s.closed || time.Since(s.last) < shmDialInterval {
+		return nil
+	}
+	s.last = time.Now()
+	s.c = s.dial()
+	return s.c
+}
+
+func (s *shmClient) dial() *shmConn {
+	announces, _ := filepath.Glob(filepath.Join(s.dir, "*.out"))
+	for _, a := range announces {
+		pid := readPid(a)
+		if !processAlive(pid) {
+			os.Remove(a)
+			continue
+		}
+		base := strings.TrimSuffix(a, ".out") + "." + s.self
+		rx, err := openShmRing(base+".res", true, pid)
+		if err != nil {
+			continue
+		}
+		tx, err := openShmRing(base+".req", true, pid)
+		if err != nil {
+			syscall.Munmap(rx.mem)
+			os.Remove(base + ".res")
+			continue
+		}
+		c := newShmConn(rx, tx, base+".res", base+".req", base+".conn")
+		go func() {
+			c.serve(func(id uuid.UUID, function string, params []byte) {
+				if function == shmFailed && len(params) == 4 {
+					s.fail(id, int32(binary.LittleEndian.Uint32(params)))
+					return
+				}
+				s.complete(id, params)
+			})
+			s.lost(c)
+		}()
+		if writeFileAtomic(base+".conn", []byte(strconv.Itoa(os.Getpid()))) != nil {
+			c.close()
+			continue
+		}
+		return c
+	}
+	return nil
+}
+
+func (s *shmClient) close() {
+	if s == nil {
+		return
+	}
+	s.m.Lock()
+	defer s.m.Unlock()
+	s.closed = true
+	if s.c != nil {
+		s.c.close()
+	}
+}
+
+// shmScanner accepts the connections of all listeners in the process. It
+// scans whenever inotify reports a change in one of their directories, or
+// every shmScanInterval if inotify is not available.
+type shmScanner struct {
+	m         *sync.Mutex
+	once      *sync.Once
+	fd        int
+	watches   map[string]*shmWatch
+	listeners map[*shmListener]struct{}
+}
+
+type shmWatch struct {
+	wd    int
+	count int
+}
+
+var shmScan = &shmScanner{
+	m:         &sync.Mutex{},
+	once:      &sync.Once{},
+	fd:        -1,
+	watches:   map[string]*shmWatch{},
+	listeners: map[*shmListener]struct{}{},
+}
+
+func (s *shmScanner) start() {
+	fd, err := syscall.InotifyInit1(syscall.IN_CLOEXEC | syscall.IN_NONBLOCK)
+	if err != nil {
+		go s.run(nil)
+		return
+	}
+	s.fd = fd
+	// A non blocking descriptor is read through the runtime poller.
+	go s.run(os.NewFile(uintptr(fd), "inotify"))
+}
+
+func (s *shmScanner) run(events *os.File) {
+	buf := make([]byte, 4096)
+	for {
+		if events != nil {
+			if _, err := events.Read(buf); err != nil {
+				events = nil
+			}
+		} else {
+			time.Sleep(shmScanInterval)
+		}
+		s.m.Lock()
+		ls := make([]*shmListener, 0, len(s.listeners))
+		for l := range s.listeners {
+			ls = append(ls, l)
+		}
+		s.m.Unlock()
+		for _, l := range ls {
+			l.scan()
+		}
+	}
+}
+
+func (s *shmScanner) add(l *shmListener) {
+	s.once.Do(s.start)
+	s.m.Lock()
+	w, ok := s.watches[l.dir]
+	if !ok {
+		w = &shmWatch{wd: -1}
+		if s.fd >= 0 {
+			w.wd, _ = syscall.InotifyAddWatch(s.fd, l.dir, syscall.IN_CREATE|syscall.IN_MOVED_TO|syscall.IN_DELETE)
+		}
+		s.watches[l.dir] = w
+	}
+	w.count++
+	s.listeners[l] = struct{}{}
+	s.m.Unlock()
+	// Connections created before the watch existed.
+	l.scan()
+}
+
+func (s *shmScanner) remove(l *shmListener) {
+	s.m.Lock()
+	defer s.m.Unlock()
+	if _, ok := s.listeners[l]; !ok {
+		return
+	}
+	delete(s.listeners, l)
+	w := s.watches[l.dir]
+	w.count--
+	if w.count == 0 {
+		if w.wd >= 0 {
+			syscall.InotifyRmWatch(s.fd, uint32(w.wd))
+		}
+		delete(s.watches, l.dir)
+	}
+}
+
+// shmListener is the output side. It announces the output and accepts the
+// connections inputs create. dispatch returns an error code for requests the
+// output does not take, which is sent back instead of a result.
+type shmListener struct {
+	m        *sync.Mutex
+	dir      string
+	announce string
+	prefix   string
+	dispatch func(*request) int32
+	conns    map[string]*shmConn
+	closed   bool
+}
+
+func newShmListener(iface string, self uuid.UUID, dispatch func(*request) int32) *shmListener {
+	if !shmEnabled {
+		return nil
+	}
+	dir := shmIfaceDir(iface)
+	if os.MkdirAll(dir, 0700) != nil {
+		return nil
+	}
+	l := &shmListener{
+		m:        &sync.Mutex{},
+		dir:      dir,
+		announce: filepath.Join(dir, string(self)+".out"),
+		prefix:   filepath.Join(dir, string(self)+"."),
+		dispatch: dispatch,
+		conns:    map[string]*shmConn{},
+	}
+	if writeFileAtomic(l.announce, []byte(strconv.Itoa(os.Getpid()))) != nil {
+		return nil
+	}
+	shmScan.add(l)
+	return l
+}
+
+// scan accepts new connections and forgets closed ones.
+func (l *shmListener) scan() {
+	conns, _ := filepath.Glob(l.prefix + "*.conn")
+	l.m.Lock()
+	defer l.m.Unlock()
+	if l.closed {
+		return
+	}
+	for path, c := range l.conns {
+		if c.isClosed() {
+			delete(l.conns, path)
+		}
+	}
+	for _, path := range conns {
+		if _, ok := l.conns[path]; ok {
+			continue
+		}
+		if c := l.open(path); c != nil {
+			l.conns[path] = c
+		}
+	}
+}
+
+func (l *shmListener) open(path string) *shmConn {
+	base := strings.TrimSuffix(path, ".conn")
+	pid := readPid(path)
+	if !processAlive(pid) {
+		os.Remove(path)
+		os.Remove(base + ".req")
+		os.Remove(base + ".res")
+		return nil
+	}
+	rx, err := openShmRing(base+".req", false, pid)
+	if err != nil {
+		return nil
+	}
+	tx, err := openShmRing(base+".res", false, pid)
+	if err != nil {
+		syscall.Munmap(rx.mem)
+		return nil
+	}
+	c := newShmConn(rx, tx, path, base+".req", base+".res")
+	go c.serve(func(id uuid.UUID, function string, params []byte) {
+		code := l.dispatch(&request{
+			UUID:     id,
+			Function: function,
+			params:   params,
+			shm:      c,
+		})
+		if code != 0 {
+			c.sendError(id, code)
+		}
+	})
+	return c
+}
+
+func (l *shmListener) close() {
+	if l == nil {
+		return
+	}
+	shmScan.remove(l)
+	os.Remove(l.announce)
+	l.m.Lock()
+	defer l.m.Unlock()
+	l.closed = true
+	for _, c := range l.conns {
+		c.close()
+	}
+}
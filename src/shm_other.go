@@ -0,0 +1,54 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+//go:build !linux
+
+package main
+
+import "github.com/ThingiverseIO/uuid"
+
+// The shared memory transport is only available on Linux.
+
+type shmConn struct{}
+
+func (c *shmConn) send(id uuid.UUID, function string, params []byte) bool {
+	return false
+}
+
+func (c *shmConn) sendError(id uuid.UUID, code int32) bool {
+	return false
+}
+
+type shmClient struct{}
+
+func newShmClient(iface string, self uuid.UUID, complete func(uuid.UUID, []byte), fail func(uuid.UUID, int32), lost func(*shmConn)) *shmClient {
+	return nil
+}
+
+func (s *shmClient) conn() *shmConn {
+	return nil
+}
+
+func (s *shmClient) close() {}
+
+type shmListener struct{}
+
+func newShmListener(iface string, self uuid.UUID, dispatch func(*request) int32) *shmListener {
+	return nil
+}
+
+func (l *shmListener) close() {}
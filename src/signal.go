@@ -0,0 +1,184 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import "C"
+
+import (
+	"sync"
+	"time"
+)
+
+// signal wakes up hosts blocked in one of the *_wait functions whenever new
+// data arrives on a handle. On request it also drives an event file
+// descriptor, which the host can add to its own poll loop. Other signals can
+// watch it, which is how tvio_poll waits on many handles at once.
+type signal struct {
+	m        *sync.Mutex
+	c        chan struct{}
+	armed    bool
+	closed   bool
+	efd      C.int
+	watchers map[*signal]struct{}
+}
+
+func newSignal() *signal {
+	return &signal{
+		m:   &sync.Mutex{},
+		c:   make(chan struct{}),
+		efd: -1,
+	}
+}
+
+// fd returns the event file descriptor of the signal, creating it on first use.
+// A new descriptor is made readable right away if pending reports queued data,
+// which arrived before there was a descriptor to signal. It fails once the
+// signal is closed.
+func (s *signal) fd(pending func() bool) (fd C.int, ok bool, err C.int) {
+	s.m.Lock()
+	if s.closed {
+		s.m.Unlock()
+		return
+	}
+	ok = true
+	created := false
+	if s.efd < 0 {
+		s.efd = newEventFD()
+		if s.efd < 0 {
+			err = ERR_NOT_SUPPORTED.asInt()
+		}
+		created = s.efd >= 0
+	}
+	fd = s.efd
+	s.m.Unlock()
+	// Data queued from now on signals the descriptor itself.
+	if created && pending() {
+		s.notify()
+	}
+	return
+}
+
+// notify wakes up all current waiters and watchers. It is cheap if nobody is
+// waiting.
+func (s *signal) notify() {
+	s.m.Lock()
+	if s.closed {
+		s.m.Unlock()
+		return
+	}
+	if s.efd >= 0 {
+		signalEventFD(s.efd)
+	}
+	if s.armed {
+		close(s.c)
+		s.c = make(chan struct{})
+		s.armed = false
+	}
+	watchers := s.watching()
+	s.m.Unlock()
+	for _, w := range watchers {
+		w.notify()
+	}
+}
+
+// close wakes up all waiters for good, it is called when the handle is removed.
+func (s *signal) close() {
+	s.m.Lock()
+	if s.closed {
+		s.m.Unlock()
+		return
+	}
+	close(s.c)
+	s.closed = true
+	if s.efd >= 0 {
+		closeEventFD(s.efd)
+		s.efd = -1
+	}
+	watchers := s.watching()
+	s.m.Unlock()
+	for _, w := range watchers {
+		w.notify()
+	}
+}
+
+// watching returns the current watchers, s.m must be held.
+func (s *signal) watching() []*signal {
+	if len(s.watchers) == 0 {
+		return nil
+	}
+	watchers := make([]*signal, 0, len(s.watchers))
+	for w := range s.watchers {
+		watchers = append(watchers, w)
+	}
+	return watchers
+}
+
+// watch makes w notified whenever s is.
+func (s *signal) watch(w *signal) {
+	s.m.Lock()
+	defer s.m.Unlock()
+	if s.watchers == nil {
+		s.watchers = map[*signal]struct{}{}
+	}
+	s.watchers[w] = struct{}{}
+}
+
+func (s *signal) unwatch(w *signal) {
+	s.m.Lock()
+	defer s.m.Unlock()
+	delete(s.watchers, w)
+}
+
+func (s *signal) isClosed() bool {
+	s.m.Lock()
+	defer s.m.Unlock()
+	return s.closed
+}
+
+func (s *signal) changed() <-chan struct{} {
+	s.m.Lock()
+	defer s.m.Unlock()
+	s.armed = true
+	return s.c
+}
+
+// wait blocks until ready returns true, the timeout in milliseconds expires
+// or the signal is closed. A timeout of 0 only checks ready once, a negative
+// timeout waits indefinitely.
+func (s *signal) wait(timeout C.int, ready func() bool) bool {
+	var expired <-chan time.Time
+	if timeout > 0 {
+		t := time.NewTimer(time.Duration(timeout) * time.Millisecond)
+		defer t.Stop()
+		expired = t.C
+	}
+	for {
+		c := s.changed()
+		if ready() {
+			return true
+		}
+		if timeout == 0 || s.isClosed() {
+			return false
+		}
+		select {
+		case <-c:
+		case <-expired:
+			return ready()
+		}
+	}
+}
@@ -0,0 +1,128 @@
+//	Copyright (c) 2017 Joern Weissenborn
+//
+//	This file is part of libthingiverseio.
+//
+//	libthingiverseio is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	libthingiverseio is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with libthingiverseio.  If not, see <http://www.gnu.org/licenses/>.
+
+package main
+
+import (
+	"math/bits"
+	"sync/atomic"
+	"time"
+)
+
+// HISTOGRAM_BUCKETS mirrors TVIO_HISTOGRAM_BUCKETS in thingiverseio.h.
+const HISTOGRAM_BUCKETS = 288
+
+// histogram is a log-linear latency histogram in nanoseconds. Values below
+// 8ns get a bucket each, above that every power of two is split into 8
+// linear sub-buckets, which bounds the relative error to 12.5%. Values
+// beyond the last bucket are counted in it.
+type histogram struct {
+	count   uint64
+	sum     uint64
+	buckets [HISTOGRAM_BUCKETS]uint64
+}
+
+func histogramBucket(ns uint64) int {
+	if ns < 8 {
+		return int(ns)
+	}
+	e := bits.Len64(ns) - 1
+	k := 8 + (e-3)*8 + int(ns>>uint(e-3)&7)
+	if k >= HISTOGRAM_BUCKETS {
+		k = HISTOGRAM_BUCKETS - 1
+	}
+	return k
+}
+
+func (h *histogram) record(d time.Duration) {
+	ns := uint64(0)
+	if d > 0 {
+		ns = uint64(d)
+	}
+	atomic.AddUint64(&h.buckets[histogramBucket(ns)], 1)
+	atomic.AddUint64(&h.sum, ns)
+	atomic.AddUint64(&h.count, 1)
+}
+
+func (h *histogram) load(dst *histogram) {
+	dst.count = atomic.LoadUint64(&h.count)
+	dst.sum = atomic.LoadUint64(&h.sum)
+	for k := range h.buckets {
+		dst.buckets[k] = atomic.LoadUint64(&h.buckets[k])
+	}
+}
+
+// inputStats mirrors tvio_input_statistics. The counters are updated atomically,
+// the depths are filled in when the statistics are read.
+type inputStats struct {
+	requestsSent    uint64
+	resultsReceived uint64
+	bytesOut        uint64
+	bytesIn         uint64
+	resultsDepth    uint64
+	callAllDepth    uint64
+	listenDepth     uint64
+	changesDepth    uint64
+	callTime        histogram
+}
+
+func (s *inputStats) sent(params []byte) {
+	atomic.AddUint64(&s.requestsSent, 1)
+	atomic.AddUint64(&s.bytesOut, uint64(len(params)))
+}
+
+func (s *inputStats) received(params []byte) {
+	atomic.AddUint64(&s.resultsReceived, 1)
+	atomic.AddUint64(&s.bytesIn, uint64(len(params)))
+}
+
+func (s *inputStats) load(dst *inputStats) {
+	dst.requestsSent = atomic.LoadUint64(&s.requestsSent)
+	dst.resultsReceived = atomic.LoadUint64(&s.resultsReceived)
+	dst.bytesOut = atomic.LoadUint64(&s.bytesOut)
+	dst.bytesIn = atomic.LoadUint64(&s.bytesIn)
+	s.callTime.load(&dst.callTime)
+}
+
+// outputStats mirrors tvio_output_statistics.
+type outputStats struct {
+	requestsReceived  uint64
+	resultsSent       uint64
+	bytesIn           uint64
+	bytesOut          uint64
+	requestsDepth     uint64
+	requestCacheDepth uint64
+	queueTime         histogram
+}
+
+func (s *outputStats) received(params []byte) {
+	atomic.AddUint64(&s.requestsReceived, 1)
+	atomic.AddUint64(&s.bytesIn, uint64(len(params)))
+}
+
+func (s *outputStats) sent(params []byte) {
+	atomic.AddUint64(&s.resultsSent, 1)
+	atomic.AddUint64(&s.bytesOut, uint64(len(params)))
+}
+
+func (s *outputStats) load(dst *outputStats) {
+	dst.requestsReceived = atomic.LoadUint64(&s.requestsReceived)
+	dst.resultsSent = atomic.LoadUint64(&s.resultsSent)
+	dst.bytesIn = atomic.LoadUint64(&s.bytesIn)
+	dst.bytesOut = atomic.LoadUint64(&s.bytesOut)
+	s.queueTime.load(&dst.queueTime)
+}
@@ -29,6 +29,26 @@ void tvio_error_message(int error, char** msg_p, int* msg_size){
 	error_message(error, msg_p, msg_size);
 }
 
+int tvio_codec_new(char* descriptor, char* function, int list, int* offsets, int n){
+	return codec_new(descriptor, function, list, offsets, n);
+}
+
+int tvio_codec_remove(int codec){
+	return codec_remove(codec);
+}
+
+int tvio_codec_pack(int codec, void* src, void* buf, int capacity, int* size){
+	return codec_pack(codec, src, buf, capacity, size);
+}
+
+int tvio_codec_unpack(int codec, void* data, int size, void* dst){
+	return codec_unpack(codec, data, size, dst);
+}
+
+int tvio_poll(void* items, int n, int timeout_ms, int* n_ready) {
+	return poll_handles(items, n, timeout_ms, n_ready);
+}
+
 int tvio_new_input(char* descriptor){
 	return new_input(descriptor);
 }
@@ -49,30 +69,114 @@ int tvio_input_connected(int input, int* is) {
 	return input_connected(input, is);
 }
 
+int tvio_input_fd(int input, int* fd) {
+	return input_fd(input, fd);
+}
+
+int tvio_input_function_id(int input, char* function, int* id){
+	return input_function_id(input, function, id);
+}
+
+int tvio_input_property_id(int input, char* property, int* id){
+	return input_property_id(input, property, id);
+}
+
 int tvio_input_call(int input, char* function, void* params, int params_size, char** id, int* id_size){
 	return input_call(input, function, params, params_size, id, id_size);
 }
 
+int tvio_input_call_bin(int input, char* function, void* params, int params_size, void* id){
+	return input_call_bin(input, function, params, params_size, id);
+}
+
+int tvio_input_call_id(int input, int function, void* params, int params_size, char** id, int* id_size){
+	return input_call_id(input, function, params, params_size, id, id_size);
+}
+
+int tvio_input_call_id_bin(int input, int function, void* params, int params_size, void* id){
+	return input_call_id_bin(input, function, params, params_size, id);
+}
+
 int tvio_input_call_all(int input, char* function, void* params, int params_size, char** id, int* id_size){
 	return input_call_all(input, function, params, params_size, id, id_size);
 }
 
+int tvio_input_call_all_bin(int input, char* function, void* params, int params_size, void* id){
+	return input_call_all_bin(input, function, params, params_size, id);
+}
+
 int tvio_input_trigger(int input, char* function, void* params, int params_size) {
 	return input_trigger(input, function, params, params_size);
 }
 
+int tvio_input_trigger_id(int input, int function, void* params, int params_size){
+	return input_trigger_id(input, function, params, params_size);
+}
+
 int tvio_input_trigger_all(int input, char* function, void* params, int params_size){
 	return input_trigger_all(input, function, params, params_size);
 }
 
+int tvio_input_call_batch(int input, int n, char** functions, void* params, int* offsets, void* ids, int* issued){
+	return input_call_batch(input, n, functions, params, offsets, ids, issued);
+}
+
+int tvio_input_trigger_batch(int input, int n, char** functions, void* params, int* offsets, int* issued){
+	return input_trigger_batch(input, n, functions, params, offsets, issued);
+}
+
 int tvio_input_call_result_available(int input, char* id, int* ready){
 	return input_call_result_available(input, id, ready);
 }
 
+int tvio_input_call_result_available_bin(int input, void* id, int* ready){
+	return input_call_result_available_bin(input, id, ready);
+}
+
+int tvio_input_call_result_wait(int input, char* id, int timeout_ms, int* ready){
+	return input_call_result_wait(input, id, timeout_ms, ready);
+}
+
+int tvio_input_call_result_wait_bin(int input, void* id, int timeout_ms, int* ready){
+	return input_call_result_wait_bin(input, id, timeout_ms, ready);
+}
+
 int tvio_input_call_result_params(int input, char* id, void** params, int* params_size){
 	return input_call_result_params(input, id, params, params_size);
 }
 
+int tvio_input_call_result_params_into(int input, char* id, void* buf, int capacity, int* params_size){
+	return input_call_result_params_into(input, id, buf, capacity, params_size);
+}
+
+int tvio_input_call_result_params_bin(int input, void* id, void** params, int* params_size){
+	return input_call_result_params_bin(input, id, params, params_size);
+}
+
+int tvio_input_completions_start(int input) {
+	return input_completions_start(input);
+}
+
+int tvio_input_completions_wait(int input, int timeout_ms, int* is) {
+	return input_completions_wait(input, timeout_ms, is);
+}
+
+int tvio_input_completions_take(int input, int max, void* ids, int* offsets, void** params, int* n) {
+	return input_completions_take(input, max, ids, offsets, params, n);
+}
+
+int tvio_input_queue_set(int input, int queue, int capacity, int policy) {
+	return input_queue_set(input, queue, capacity, policy);
+}
+
+int tvio_input_queue_stats(int input, int queue, int* length, unsigned long long* dropped, unsigned long long* rejected) {
+	return input_queue_stats(input, queue, length, dropped, rejected);
+}
+
+int tvio_input_stats(int input, void* stats) {
+	return input_stats(input, stats);
+}
+
 int tvio_input_listen_start(int input, char* function){
 	return input_listen_start(input, function);
 }
@@ -85,10 +189,18 @@ int tvio_input_listen_result_available(int input, int* is){
 	return input_listen_result_available(input, is);
 }
 
+int tvio_input_listen_result_wait(int input, int timeout_ms, int* is){
+	return input_listen_result_wait(input, timeout_ms, is);
+}
+
 int tvio_input_listen_result_id(int input, char** id, int* id_size) {
 	return input_listen_result_id(input, id, id_size);
 }
 
+int tvio_input_listen_result_id_bin(int input, void* id) {
+	return input_listen_result_id_bin(input, id);
+}
+
 int tvio_input_listen_result_function(int input, char** function, int* function_size){
 	return input_listen_result_function(input, function, function_size);
 }
@@ -97,34 +209,82 @@ int tvio_input_listen_result_params(int input, void** params, int* params_size){
 	return input_listen_result_params(input, params, params_size);
 }
 
+int tvio_input_listen_result_params_into(int input, void* buf, int capacity, int* params_size){
+	return input_listen_result_params_into(input, buf, capacity, params_size);
+}
+
 int tvio_input_listen_result_request_params(int input, void** params, int* params_size){
 	return input_listen_result_request_params(input, params, params_size);
 }
 
+int tvio_input_listen_result_request_params_into(int input, void* buf, int capacity, int* params_size){
+	return input_listen_result_request_params_into(input, buf, capacity, params_size);
+}
+
 int tvio_input_listen_result_clear(int input) {
 	return input_listen_result_clear(input);
 }
 
+int tvio_input_listen_result_take(int input, char** id, char** function, void** request_params, int* request_params_size, void** params, int* params_size) {
+	return input_listen_result_take(input, id, function, request_params, request_params_size, params, params_size);
+}
+
 int tvio_input_call_all_next_result_available(int input, int* is) {
 	return tvio_input_call_all_next_result_available(input, is);
 }
 
+int tvio_input_call_all_next_result_available_bin(int input, void* id, int* is) {
+	return input_call_all_next_result_available_bin(input, id, is);
+}
+
 int tvio_input_call_all_next_result_params(int input, char* id, void** params, int* params_size){
 	return input_call_all_next_result_params(input, id , params, params_size);
 }
 
+int tvio_input_call_all_next_result_params_into(int input, char* id, void* buf, int capacity, int* params_size){
+	return input_call_all_next_result_params_into(input, id, buf, capacity, params_size);
+}
+
+int tvio_input_call_all_next_result_params_bin(int input, void* id, void** params, int* params_size){
+	return input_call_all_next_result_params_bin(input, id , params, params_size);
+}
+
 int tvio_input_call_all_next_result_clear(int input, char* id) {
 	return input_call_all_next_result_clear(input, id);
 }
 
+int tvio_input_call_all_next_result_clear_bin(int input, void* id) {
+	return input_call_all_next_result_clear_bin(input, id);
+}
+
 int tvio_input_call_all_request_clear(int input, char* id) {
 	return input_call_all_request_clear(input, id);
 }
 
+int tvio_input_call_all_request_clear_bin(int input, void* id) {
+	return input_call_all_request_clear_bin(input, id);
+}
+
 int tvio_input_property_get(int input, char* property, void** value, int* value_size) {
 	return input_property_get(input, property, value, value_size);
 }
 
+int tvio_input_property_get_into(int input, char* property, void* buf, int capacity, int* value_size){
+	return input_property_get_into(input, property, buf, capacity, value_size);
+}
+
+int tvio_input_property_get_id(int input, int property, void** value, int* value_size){
+	return input_property_get_id(input, property, value, value_size);
+}
+
+int tvio_input_property_get_into_id(int input, int property, void* buf, int capacity, int* value_size){
+	return input_property_get_into_id(input, property, buf, capacity, value_size);
+}
+
+int tvio_input_property_mirror(int input, char* property, int capacity, void** mirror) {
+	return input_property_mirror(input, property, capacity, mirror);
+}
+
 int tvio_input_property_update(int input, char* property){
 	return input_property_update(input, property);
 }
@@ -137,10 +297,18 @@ int tvio_input_property_update_get(int input, char* property, void** value, int*
 	return input_property_update_get(input, property, value, value_size);
 }
 
+int tvio_input_property_update_get_into(int input, char* property, void* buf, int capacity, int* value_size){
+	return input_property_update_get_into(input, property, buf, capacity, value_size);
+}
+
 int tvio_input_change_start_observe(int input, char* property){
 	return input_change_start_observe(input, property);
 }
 
+int tvio_input_change_start_observe_coalesced(int input, char* property) {
+	return input_change_start_observe_coalesced(input, property);
+}
+
 int tvio_input_change_stop_observe(int input, char* property){
 	return input_change_stop_observe(input, property);
 }
@@ -149,6 +317,10 @@ int tvio_input_change_available(int input, int* is){
 	return input_change_available(input, is);
 }
 
+int tvio_input_change_wait(int input, int timeout_ms, int* is){
+	return input_change_wait(input, timeout_ms, is);
+}
+
 int tvio_input_change_property(int input, char** property, int* property_size){
 	return input_change_property(input, property, property_size);
 }
@@ -157,6 +329,14 @@ int tvio_input_change_value(int input, void** value, int* value_size){
 	return input_change_value(input, value, value_size);
 }
 
+int tvio_input_change_value_into(int input, void* buf, int capacity, int* value_size){
+	return input_change_value_into(input, buf, capacity, value_size);
+}
+
+int tvio_input_change_take(int input, char** property, void** value, int* value_size){
+	return input_change_take(input, property, value, value_size);
+}
+
 int tvio_input_change_clear(int input){
 	return input_change_clear(input);
 }
@@ -181,32 +361,116 @@ int tvio_output_connected(int output, int* is) {
 	return output_connected(output, is);
 }
 
+int tvio_output_fd(int output, int* fd) {
+	return output_fd(output, fd);
+}
+
+int tvio_output_set_request_handler(int output, void (*handler)(int, char*, char*, void*, int, void*), void* userdata) {
+	return output_set_request_handler(output, handler, userdata);
+}
+
+int tvio_output_serve(int output, int nthreads, void (*handler)(int, int, int, void*, int, void**, int*, void*), void* userdata) {
+	return output_serve(output, nthreads, handler, userdata);
+}
+
+int tvio_output_request_take(int output, char** id, char** function, void** params, int* params_size){
+	return output_request_take(output, id, function, params, params_size);
+}
+
+int tvio_output_queue_set(int output, int capacity, int policy) {
+	return output_queue_set(output, capacity, policy);
+}
+
+int tvio_output_queue_stats(int output, int* length, unsigned long long* dropped, unsigned long long* rejected) {
+	return output_queue_stats(output, length, dropped, rejected);
+}
+
+int tvio_output_stats(int output, void* stats) {
+	return output_stats(output, stats);
+}
+
+int tvio_output_request_take_batch(int output, int max, char** ids, char** functions, int* offsets, void** params, int* n){
+	return output_request_take_batch(output, max, ids, functions, offsets, params, n);
+}
+
 int tvio_output_request_available(int output, int* is){
   return output_request_available(output, is);
 }
 
+int tvio_output_request_wait(int output, int timeout_ms, int* is){
+	return output_request_wait(output, timeout_ms, is);
+}
+
 int tvio_output_request_id(int output, char** id, int* id_size){
 	return output_request_id(output, id, id_size);
 }
 
+int tvio_output_request_id_bin(int output, void* id){
+	return output_request_id_bin(output, id);
+}
+
 int tvio_output_request_function(int output, char* id, char** function, int* function_size){
 	return output_request_function(output, id ,function, function_size);
 }
 
+int tvio_output_request_function_bin(int output, void* id, char** function, int* function_size){
+	return output_request_function_bin(output, id ,function, function_size);
+}
+
 int tvio_output_request_params(int output, char* id, void** params, int* params_size){
 	return output_request_params(output, id ,params, params_size);
 }
 
+int tvio_output_request_params_into(int output, char* id, void* buf, int capacity, int* params_size){
+	return output_request_params_into(output, id, buf, capacity, params_size);
+}
+
+int tvio_output_request_params_bin(int output, void* id, void** params, int* params_size){
+	return output_request_params_bin(output, id ,params, params_size);
+}
+
 int tvio_output_reply(int output, char* id, void* params, int params_size){
 	return output_reply(output, id , params, params_size);
 }
 
+int tvio_output_reply_nocopy(int output, char* id, void* params, int params_size, void (*release)(void*, void*), void* userdata){
+	return output_reply_nocopy(output, id, params, params_size, release, userdata);
+}
+
+int tvio_output_reply_bin(int output, void* id, void* params, int params_size){
+	return output_reply_bin(output, id , params, params_size);
+}
+
+int tvio_output_reply_batch(int output, int n, char** ids, void* params, int* offsets){
+	return output_reply_batch(output, n, ids, params, offsets);
+}
+
+int tvio_output_function_id(int output, char* function, int* id){
+	return output_function_id(output, function, id);
+}
+
+int tvio_output_property_id(int output, char* property, int* id){
+	return output_property_id(output, property, id);
+}
+
 int tvio_output_emit(int output, char* function, void* in_params, int in_params_size, void* params, int params_size){
 	return output_emit(output, function, in_params, in_params_size, params, params_size);
 }
 
+int tvio_output_emit_id(int output, int function, void* in_params, int in_params_size, void* params, int params_size){
+	return output_emit_id(output, function, in_params, in_params_size, params, params_size);
+}
+
 int tvio_output_property_set(int output, char* property, void* value, int value_size){
 	return output_property_set(output, property, value, value_size);
 }
 
+int tvio_output_property_set_id(int output, int property, void* value, int value_size){
+	return output_property_set_id(output, property, value, value_size);
+}
+
+// The Go benchmarks and the C++ tests link this file into programs which have
+// their own main.
+#ifndef TVIO_NO_MAIN
 int main(){}
+#endif
@@ -0,0 +1,91 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <thread>
+
+#include "thingiverseio_coro.hpp"
+
+static const char* DESCRIPTOR = "function SayHello(Greeting string) (Answer string)";
+
+static const int CALLS = 16;
+
+static int served;
+static int answered;
+static int failed;
+
+// Replies to CALLS requests, each with the parameters of the request.
+static tvio::detached serve(tvio::AsyncOutput& async, tvio::Output& output) {
+	for (int k = 0; k < CALLS; k++) {
+		tvio::Request request = co_await async.next_request();
+		if (request.function != "SayHello" || !output.reply(request.id, request.params)) {
+			failed++;
+		}
+		served++;
+	}
+}
+
+static tvio::detached call(tvio::AsyncInput& async, int k) {
+	char params[16];
+	int size = std::snprintf(params, sizeof(params), "HELLO %d", k);
+	auto result = co_await async.call("SayHello", tvio::as_bytes({params, static_cast<std::size_t>(size)}));
+	if (!result || result->str() != std::string_view(params, static_cast<std::size_t>(size))) {
+		failed++;
+	}
+	answered++;
+}
+
+int main() {
+	using namespace std::chrono_literals;
+
+	printf("Testing C++ Coroutines...\n");
+
+	auto input = tvio::Input::create(DESCRIPTOR);
+	auto output = tvio::Output::create(DESCRIPTOR);
+	if (!input || !output) {
+		printf("FAIL, create err %d %d\n", static_cast<int>(input.error()), static_cast<int>(output.error()));
+		return 1;
+	}
+	for (int k = 0; k < 100 && !input->connected().value(); k++) {
+		std::this_thread::sleep_for(100ms);
+	}
+
+	tvio::AsyncInput async_input(*input);
+	tvio::AsyncOutput async_output(*output);
+	if (auto err = async_input.start(); !err || async_input.fd() < 0 || async_output.fd() < 0) {
+		printf("FAIL, start err %d\n", static_cast<int>(err.error()));
+		return 1;
+	}
+
+	serve(async_output, *output);
+	for (int k = 0; k < CALLS; k++) {
+		call(async_input, k);
+	}
+
+	// A single thread drives both sides through their descriptors.
+	struct pollfd fds[2] = {{async_input.fd(), POLLIN, 0}, {async_output.fd(), POLLIN, 0}};
+	auto deadline = std::chrono::steady_clock::now() + 10s;
+	while (answered < CALLS && std::chrono::steady_clock::now() < deadline) {
+		if (poll(fds, 2, 100) < 0) {
+			printf("FAIL, poll\n");
+			return 1;
+		}
+		if (fds[0].revents & POLLIN) {
+			async_input.dispatch();
+		}
+		if (fds[1].revents & POLLIN) {
+			async_output.dispatch();
+		}
+	}
+	if (answered != CALLS || served != CALLS || failed != 0) {
+		printf("FAIL, %d answered, %d served, %d failed\n", answered, served, failed);
+		return 1;
+	}
+	if (async_input.pending() != 0 || async_output.pending() != 0) {
+		printf("FAIL, coroutines are still waiting\n");
+		return 1;
+	}
+
+	printf("SUCCESS\n");
+	return 0;
+}
@@ -0,0 +1,154 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "thingiverseio.hpp"
+
+static const char* DESCRIPTOR = "function SayHello(Greeting string) (Answer string)\n"
+				"property testprop: Mood string";
+
+static int released;
+
+static void release_count(void*, void*) {
+	released++;
+}
+
+static bool equal(tvio::bytes_view a, tvio::bytes_view b) {
+	return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+int main() {
+	using namespace std::chrono_literals;
+
+	printf("Testing C++ Creation...\n");
+
+	auto input = tvio::Input::create(DESCRIPTOR);
+	auto output = tvio::Output::create(DESCRIPTOR);
+	if (!input || !output) {
+		printf("FAIL, create err %d %d\n", static_cast<int>(input.error()), static_cast<int>(output.error()));
+		return 1;
+	}
+	for (int k = 0; k < 100 && !input->connected().value(); k++) {
+		std::this_thread::sleep_for(100ms);
+	}
+	if (!input->connected().value()) {
+		printf("FAIL, input did not connect\n");
+		return 1;
+	}
+
+	printf("SUCCESS\n");
+
+	printf("Testing C++ Call...\n");
+
+	auto params = tvio::as_bytes("HELLO");
+	auto reply = tvio::as_bytes("HELLO_BACK");
+	auto id = input->call("SayHello", params);
+	if (!id) {
+		printf("FAIL, call err %d\n", static_cast<int>(id.error()));
+		return 1;
+	}
+	auto ready = output->wait_request(5000ms);
+	if (!ready || !*ready) {
+		printf("FAIL, request hasnt arrived\n");
+		return 1;
+	}
+	auto request = output->take_request();
+	if (!request || request->id != id->str() || request->function != "SayHello" || !equal(request->params, params)) {
+		printf("FAIL, take_request err %d\n", static_cast<int>(request.error()));
+		return 1;
+	}
+	if (auto err = output->reply(request->id, reply); !err) {
+		printf("FAIL, reply err %d\n", static_cast<int>(err.error()));
+		return 1;
+	}
+	ready = input->wait_result(id->c_str(), 5000ms);
+	if (!ready || !*ready) {
+		printf("FAIL, result hasnt arrived\n");
+		return 1;
+	}
+	// A buffer which is too small keeps the result.
+	std::byte small[4];
+	int size = 0;
+	auto copied = input->take_result_into(id->c_str(), {small, sizeof(small)}, &size);
+	if (copied || copied.error() != tvio::errc::buffer_too_small || size != static_cast<int>(reply.size())) {
+		printf("FAIL, take_result_into err %d size %d\n", static_cast<int>(copied.error()), size);
+		return 1;
+	}
+	auto result = input->take_result(id->c_str());
+	if (!result || !equal(result->bytes(), reply)) {
+		printf("FAIL, take_result err %d\n", static_cast<int>(result.error()));
+		return 1;
+	}
+	if (input->take_result(id->c_str()).error() != tvio::errc::invalid_result_id) {
+		printf("FAIL, result was not cleared\n");
+		return 1;
+	}
+
+	printf("SUCCESS\n");
+
+	printf("Testing C++ Nocopy and Stats...\n");
+
+	auto before = output->stats();
+	id = input->call("SayHello", params);
+	ready = output->wait_request(5000ms);
+	request = output->take_request();
+	if (!id || !ready || !*ready || !request) {
+		printf("FAIL, nocopy request hasnt arrived\n");
+		return 1;
+	}
+	if (auto err = output->reply_nocopy(request->id, reply, release_count, &released); !err || released != 1) {
+		printf("FAIL, reply_nocopy err %d, released %d times\n", static_cast<int>(err.error()), released);
+		return 1;
+	}
+	ready = input->wait_result(id->c_str(), 5000ms);
+	result = input->take_result(id->c_str());
+	if (!ready || !result || !equal(result->bytes(), reply)) {
+		printf("FAIL, nocopy result err %d\n", static_cast<int>(result.error()));
+		return 1;
+	}
+	auto after = output->stats();
+	if (!before || !after || after->requests_received != before->requests_received + 1 || after->results_sent != before->results_sent + 1) {
+		printf("FAIL, output stats did not count the request\n");
+		return 1;
+	}
+	auto queue = output->queue_stats();
+	if (!queue || queue->length != 0 || queue->dropped != 0 || queue->rejected != 0) {
+		printf("FAIL, queue_stats err %d\n", static_cast<int>(queue.error()));
+		return 1;
+	}
+	if (output->queue_set(1, TVIO_QUEUE_REJECT).error() != tvio::errc::ok || output->queue_set(0, 42).error() != tvio::errc::invalid_queue) {
+		printf("FAIL, queue_set\n");
+		return 1;
+	}
+
+	printf("SUCCESS\n");
+
+	printf("Testing C++ Mirror...\n");
+
+	if (auto err = output->set_property("testprop", params); !err) {
+		printf("FAIL, set_property err %d\n", static_cast<int>(err.error()));
+		return 1;
+	}
+	auto mirror = input->property_mirror("testprop", 64);
+	if (!mirror) {
+		printf("FAIL, property_mirror err %d\n", static_cast<int>(mirror.error()));
+		return 1;
+	}
+	std::byte value[64];
+	tvio::result<std::size_t> n = tvio::errc::no_update;
+	for (int k = 0; k < 5000; k++) {
+		n = tvio::read_mirror(*mirror, {value, sizeof(value)});
+		if (n && equal({value, *n}, params)) {
+			break;
+		}
+		std::this_thread::sleep_for(1ms);
+	}
+	if (!n || !equal({value, *n}, params)) {
+		printf("FAIL, read_mirror err %d\n", static_cast<int>(n.error()));
+		return 1;
+	}
+
+	printf("SUCCESS\n");
+	return 0;
+}
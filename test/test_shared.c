@@ -1,9 +1,72 @@
 #include<stdio.h>
+#include<poll.h>
+#include<string.h>
+#include<stddef.h>
+#include<unistd.h>
 #include "libtvio.h"
+#include "thingiverseio.h"
 
   char * const DESCRIPTOR = "function SayHello(Greeting string) (Answer string)\n"
   			    "property testprop: Mood string";
 
+  static void serve_echo(int output, int worker, int function, void* params, int params_size, void** reply, int* reply_size, void* userdata) {
+	*reply = malloc(params_size);
+	memcpy(*reply, params, params_size);
+	*reply_size = params_size;
+  }
+
+  // Waits until the request queue of output reports the given counters.
+  static int wait_queue(int output, int length, unsigned long long dropped, unsigned long long rejected) {
+	int l;
+	unsigned long long d, r;
+	for (int k = 0; k < 5000; k++) {
+		if (output_queue_stats(output, &l, &d, &r) == 0 && l == length && d == dropped && r == rejected) {
+			return 1;
+		}
+		usleep(1000);
+	}
+	printf("queue is %d %llu %llu, want %d %llu %llu\n", l, d, r, length, dropped, rejected);
+	return 0;
+  }
+
+  // Takes the next request of output and checks its parameters.
+  static int take_request(int output, char* want) {
+	char *id, *function;
+	void* params;
+	int params_size;
+	if (output_request_take(output, &id, &function, &params, &params_size) != 0) {
+		return 0;
+	}
+	int ok = params_size == strlen(want) && memcmp(params, want, params_size) == 0;
+	free(id);
+	return ok;
+  }
+
+  static int trigger_abc(int input) {
+	return input_trigger(input, "SayHello", "A", 1) == 0 &&
+		input_trigger(input, "SayHello", "B", 1) == 0 &&
+		input_trigger(input, "SayHello", "C", 1) == 0;
+  }
+
+  static int handled;
+
+  static void handle_echo(int output, char* id, char* function, void* params, int params_size, void* userdata) {
+	if (strcmp(function, "SayHello") == 0 && userdata == &handled) {
+		handled++;
+		output_reply(output, id, params, params_size);
+	}
+  }
+
+  static int released;
+  static void* released_data;
+  static void* released_userdata;
+
+  static void release_count(void* data, void* userdata) {
+	released++;
+	released_data = data;
+	released_userdata = userdata;
+  }
+
   int main() {
 
 
@@ -11,6 +74,11 @@
 	  printf(DESCRIPTOR);
 	  printf("\n\n");
 
+	// CALLs to an output in this process are handed over directly, unless
+	// TVIO_LOCAL=0.
+	char * local = getenv("TVIO_LOCAL");
+	int local_calls = local == NULL || strcmp(local, "0") != 0;
+
 	printf("Testing Input Creation...\n");
 
 	int input = new_input(DESCRIPTOR);
@@ -65,7 +133,35 @@
 		return 1;
 	};
 
-	sleep(1);
+	struct pollfd pfd;
+	err = output_fd(output, &pfd.fd);
+	if (err != 0) {
+		printf("FAIL, output_fd err %d\n", err);
+		return 1;
+	};
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, 5000) != 1) {
+		printf("FAIL, output fd did not become readable\n");
+		return 1;
+	}
+
+	tvio_poll_item item = {output, TVIO_POLL_OUTPUT, 0};
+	int n_ready;
+	err = poll_handles(&item, 1, 5000, &n_ready);
+	if (err != 0 || n_ready != 1 || item.ready != TVIO_POLL_REQUEST) {
+		printf("FAIL, poll err %d ready %d\n", err, item.ready);
+		return 1;
+	}
+
+	err = output_request_wait(output, 5000, &is);
+	if (err != 0) {
+		printf("FAIL, request_wait err not 0\n");
+		return 1;
+	};
+	if (is != 1) {
+		printf("FAIL, request hasnt arrived\n");
+		return 1;
+	}
 
 	char * req_uuid;
 	int req_uuid_size;
@@ -111,9 +207,13 @@
 		return 1;
 	};
 
-	sleep(1);
-
 	int ready;
+	err = input_call_result_wait(input, uuid, 5000, &ready);
+	if (err != 0) {
+		printf("FAIL, result_wait err not 0\n");
+		return 1;
+	};
+
 	err = input_call_result_available(input, uuid, &ready);
 	if (err != 0) {
 		printf("FAIL, err not 0\n");
@@ -138,6 +238,116 @@
 
 	printf("SUCCESS\n");
 
+	printf("Testing Input FD...\n");
+
+	// The result arrives before the descriptor exists, it must still be
+	// readable once it is created.
+	err = input_call(input, fun, params, params_size, &uuid, &uuid_size);
+	if (err != 0) {
+		printf("FAIL input call err %d\n", err);
+		return 1;
+	};
+	err = output_request_wait(output, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, request hasnt arrived\n");
+		return 1;
+	};
+	err = output_request_take(output, &req_uuid, &rfun, &rparams, &rparams_size);
+	if (err != 0) {
+		printf("FAIL, request_take err %d\n", err);
+		return 1;
+	};
+	err = output_reply(output, req_uuid, resparams, resparams_size);
+	free(req_uuid);
+	if (err != 0) {
+		printf("FAIL, reply err %d\n", err);
+		return 1;
+	};
+	err = input_call_result_wait(input, uuid, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, result hasnt arrived\n");
+		return 1;
+	};
+	struct pollfd ipfd;
+	err = input_fd(input, &ipfd.fd);
+	if (err != 0) {
+		printf("FAIL, input_fd err %d\n", err);
+		return 1;
+	};
+	ipfd.events = POLLIN;
+	if (poll(&ipfd, 1, 0) != 1) {
+		printf("FAIL, input fd is not readable with a pending result\n");
+		return 1;
+	}
+	// A negative capacity must leave the result in place.
+	err = input_call_result_params_into(input, uuid, NULL, -1, &resultparams_size);
+	if (err != TVIO_ERR_BUFFER_TOO_SMALL || resultparams_size != resparams_size) {
+		printf("FAIL, result_params_into with negative capacity err %d\n", err);
+		return 1;
+	};
+	err = input_call_result_params(input, uuid, &resultparams, &resultparams_size);
+	if (err != 0) {
+		printf("FAIL, result_params err %d\n", err);
+		return 1;
+	};
+	free(resultparams);
+	free(uuid);
+
+	printf("SUCCESS\n");
+
+	printf("Testing Completions...\n");
+
+	err = input_completions_start(input);
+	if (err != 0) {
+		printf("FAIL, completions_start err %d\n", err);
+		return 1;
+	};
+
+	err = input_call(input, fun, params, params_size, &uuid, &uuid_size);
+	if (err != 0) {
+		printf("FAIL input call err %d\n", err);
+		return 1;
+	};
+
+	err = output_request_wait(output, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, request hasnt arrived\n");
+		return 1;
+	};
+	err = output_request_take(output, &req_uuid, &rfun, &rparams, &rparams_size);
+	if (err != 0) {
+		printf("FAIL, request_take err %d\n", err);
+		return 1;
+	};
+	err = output_reply(output, req_uuid, resparams, resparams_size);
+	if (err != 0) {
+		printf("FAIL, reply err %d\n", err);
+		return 1;
+	};
+	free(req_uuid);
+
+	err = input_completions_wait(input, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, no completion\n");
+		return 1;
+	};
+	char completion_ids[16];
+	int completion_offsets[2];
+	void * completion_params;
+	int completions;
+	err = input_completions_take(input, 1, completion_ids, completion_offsets, &completion_params, &completions);
+	if (err != 0) {
+		printf("FAIL, completions_take err %d\n", err);
+		return 1;
+	};
+	if (completions != 1 || completion_offsets[1] != 10) {
+		printf("FAIL, got %d completions\n", completions);
+		return 1;
+	};
+	free(completion_params);
+
+	printf("SUCCESS\n");
+
 	printf("Testing Trigger...\n");
 
 	err = input_listen_start(input, fun);
@@ -153,15 +363,23 @@
 		printf("FAIL, trigger err not 0\n");
 		return 1;
 	};
-	sleep(1);
+	err = output_request_wait(output, 5000, &is);
+	if (err != 0) {
+		printf("FAIL, request_wait err not 0\n");
+		return 1;
+	};
 
-	err = output_request_id(output, &req_uuid, &req_uuid_size);
+	err = output_request_take(output, &req_uuid, &rfun, &rparams, &rparams_size);
 	if (err != 0) {
-		printf("FAIL, get_gext_req err not 0\n");
+		printf("FAIL, request_take err not 0\n");
 		return 1;
 	};
-	if (req_uuid_size == 0) {
-		printf("FAIL, req_uuid_size is 0\n");
+	if (strcmp(rfun, fun) != 0) {
+		printf("FAIL, request function is %s, want %s\n", rfun, fun);
+		return 1;
+	};
+	if (rparams_size != params_size) {
+		printf("FAIL, rparams_size is %d, want %d\n", rparams_size, params_size);
 		return 1;
 	};
 
@@ -171,7 +389,11 @@
 		return 1;
 	};
 
-	sleep(1);
+	err = input_listen_result_wait(input, 5000, &ready);
+	if (err != 0) {
+		printf("FAIL,listen_result_wait err not 0\n");
+		return 1;
+	};
 
 	err = input_listen_result_available(input, &ready);
 	if (err != 0) {
@@ -210,7 +432,11 @@
 		return 1;
 	};
 
-	sleep(1);
+	err = input_change_wait(input, 5000, &ready);
+	if (err != 0) {
+		printf("FAIL,change_wait err not 0\n");
+		return 1;
+	};
 
 	err = input_change_available(input, &ready);
 	if (err != 0) {
@@ -230,17 +456,693 @@
 		printf("FAIL, property value size is %d, not %d\n", resultparams_size, 5);
 		return 1;
 	};
-	err = input_remove(input);
+	char value_buf[64];
+	err = input_change_value_into(input, value_buf, 2, &resultparams_size);
+	if (err != TVIO_ERR_BUFFER_TOO_SMALL || resultparams_size != 5) {
+		printf("FAIL, change_value_into with small buffer err %d size %d\n", err, resultparams_size);
+		return 1;
+	};
+	err = input_change_value_into(input, value_buf, sizeof(value_buf), &resultparams_size);
+	if (err != 0 || memcmp(value_buf, params, params_size) != 0) {
+		printf("FAIL, change_value_into err %d\n", err);
+		return 1;
+	};
+
+	printf("SUCCESS\n");
+
+	printf("Testing Coalesced Observe...\n");
+
+	char* change_prop;
+	err = input_change_stop_observe(input, prop);
 	if (err != 0) {
-		printf("FAIL, remove_input err %d\n", err);
+		printf("FAIL, change_stop_observe err %d\n", err);
+		return 1;
+	};
+	while (input_change_take(input, &change_prop, &resultparams, &resultparams_size) == 0) {
+		free(change_prop);
+	}
+	err = input_change_start_observe_coalesced(input, prop);
+	if (err != 0) {
+		printf("FAIL, change_start_observe_coalesced err %d\n", err);
+		return 1;
+	};
+	if (output_property_set(output, prop, "V1", 2) != 0 || output_property_set(output, prop, "V2", 2) != 0 ||
+	    output_property_set(output, prop, "V3", 2) != 0) {
+		printf("FAIL, property_set failed\n");
+		return 1;
+	}
+	// Every change up to the last one is pending at once, they share a
+	// single entry of the change queue.
+	for (int k = 0; k < 5000; k++) {
+		err = input_change_value_into(input, value_buf, sizeof(value_buf), &resultparams_size);
+		if (err == 0 && resultparams_size == 2 && memcmp(value_buf, "V3", 2) == 0) {
+			break;
+		}
+		usleep(1000);
+	}
+	int changes_length;
+	unsigned long long changes_dropped, changes_rejected;
+	err = input_queue_stats(input, TVIO_QUEUE_CHANGE, &changes_length, &changes_dropped, &changes_rejected);
+	if (err != 0 || changes_length != 1) {
+		printf("FAIL, %d coalesced changes queued, err %d\n", changes_length, err);
+		return 1;
+	};
+	err = input_change_take(input, &change_prop, &resultparams, &resultparams_size);
+	if (err != 0 || strcmp(change_prop, prop) != 0 || resultparams_size != 2 || memcmp(resultparams, "V3", 2) != 0) {
+		printf("FAIL, coalesced change_take err %d\n", err);
+		return 1;
+	};
+	free(change_prop);
+	err = input_change_available(input, &ready);
+	if (err != 0 || ready != 0) {
+		printf("FAIL, coalesced change was queued twice\n");
+		return 1;
+	};
+	// Restore the value the following tests expect.
+	err = output_property_set(output, prop, params, params_size);
+	if (err != 0) {
+		printf("FAIL, property_set err %d\n", err);
+		return 1;
+	};
+	err = input_change_wait(input, 5000, &ready);
+	if (err != 0 || ready != 1) {
+		printf("FAIL, restored value hasnt arrived\n");
+		return 1;
+	};
+
+	printf("SUCCESS\n");
+
+	printf("Testing Mirror...\n");
+
+	// The mirror observes the property itself, without queueing changes.
+	err = input_change_stop_observe(input, prop);
+	if (err != 0) {
+		printf("FAIL, change_stop_observe err %d\n", err);
+		return 1;
+	};
+	while (input_change_take(input, &change_prop, &resultparams, &resultparams_size) == 0) {
+		free(change_prop);
+	}
+	tvio_property_mirror* mirror;
+	err = input_property_mirror(input, prop, sizeof(value_buf), (void**)&mirror);
+	if (err != 0) {
+		printf("FAIL, property_mirror err %d\n", err);
 		return 1;
 	};
+	tvio_property_mirror* same_mirror;
+	err = input_property_mirror(input, prop, 1, (void**)&same_mirror);
+	if (err != 0 || same_mirror != mirror) {
+		printf("FAIL, second property_mirror err %d\n", err);
+		return 1;
+	};
+	err = input_property_mirror(input, prop, sizeof(value_buf) + 1, (void**)&same_mirror);
+	if (err != TVIO_ERR_BUFFER_TOO_SMALL) {
+		printf("FAIL, property_mirror with larger capacity err %d\n", err);
+		return 1;
+	};
+	err = tvio_property_mirror_read(mirror, value_buf, sizeof(value_buf), &resultparams_size);
+	if (err != TVIO_NO_ERR || resultparams_size != params_size || memcmp(value_buf, params, params_size) != 0) {
+		printf("FAIL, initial mirror_read err %d\n", err);
+		return 1;
+	};
+	err = output_property_set(output, prop, "M1", 2);
+	if (err != 0) {
+		printf("FAIL, property_set err %d\n", err);
+		return 1;
+	};
+	for (int k = 0; k < 5000; k++) {
+		err = tvio_property_mirror_read(mirror, value_buf, sizeof(value_buf), &resultparams_size);
+		if (err == TVIO_NO_ERR && resultparams_size == 2 && memcmp(value_buf, "M1", 2) == 0) {
+			break;
+		}
+		usleep(1000);
+	}
+	if (resultparams_size != 2 || memcmp(value_buf, "M1", 2) != 0) {
+		printf("FAIL, mirror was not updated\n");
+		return 1;
+	};
+	err = tvio_property_mirror_read(mirror, value_buf, 1, &resultparams_size);
+	if (err != TVIO_ERR_BUFFER_TOO_SMALL || resultparams_size != 2) {
+		printf("FAIL, mirror_read with small buffer err %d\n", err);
+		return 1;
+	};
+	err = input_change_available(input, &ready);
+	if (err != 0 || ready != 0) {
+		printf("FAIL, mirror queued a change\n");
+		return 1;
+	};
+	err = output_property_set(output, prop, params, params_size);
+	if (err != 0) {
+		printf("FAIL, property_set err %d\n", err);
+		return 1;
+	};
+	for (int k = 0; k < 5000; k++) {
+		err = tvio_property_mirror_read(mirror, value_buf, sizeof(value_buf), &resultparams_size);
+		if (err == TVIO_NO_ERR && resultparams_size == params_size) {
+			break;
+		}
+		usleep(1000);
+	}
+
+	printf("SUCCESS\n");
+
+	printf("Testing IDs...\n");
+
+	int fun_id, prop_id;
+	err = input_function_id(input, fun, &fun_id);
+	if (err != 0 || fun_id != 0) {
+		printf("FAIL, input_function_id err %d id %d\n", err, fun_id);
+		return 1;
+	};
+	err = input_function_id(input, "NoSuchFunction", &fun_id);
+	if (err != TVIO_ERR_INVALID_FUNCTION) {
+		printf("FAIL, input_function_id of unknown function err %d\n", err);
+		return 1;
+	};
+	err = input_trigger_id(input, 1, params, params_size);
+	if (err != TVIO_ERR_INVALID_FUNCTION) {
+		printf("FAIL, input_trigger_id with invalid id err %d\n", err);
+		return 1;
+	};
+	err = output_property_id(output, prop, &prop_id);
+	if (err != 0 || prop_id != 0) {
+		printf("FAIL, output_property_id err %d id %d\n", err, prop_id);
+		return 1;
+	};
+	err = output_property_set_id(output, prop_id, params, params_size);
+	if (err != 0) {
+		printf("FAIL, output_property_set_id err %d\n", err);
+		return 1;
+	};
+	err = input_property_id(input, prop, &prop_id);
+	if (err != 0) {
+		printf("FAIL, input_property_id err %d\n", err);
+		return 1;
+	};
+	err = input_property_get_into_id(input, prop_id, value_buf, sizeof(value_buf), &resultparams_size);
+	if (err != 0 || resultparams_size != params_size) {
+		printf("FAIL, input_property_get_into_id err %d size %d\n", err, resultparams_size);
+		return 1;
+	};
+
+	printf("SUCCESS\n");
+
+	printf("Testing Codec...\n");
+
+	struct say_hello {
+		struct {
+			void* data;
+			int size;
+		} Greeting;
+	} hello, unpacked;
+	int offsets[1] = {offsetof(struct say_hello, Greeting)};
+	int codec = codec_new(DESCRIPTOR, fun, 0, offsets, 1);
+	if (codec < 0) {
+		printf("FAIL, codec_new err %d\n", codec);
+		return 1;
+	};
+	hello.Greeting.data = params;
+	hello.Greeting.size = params_size;
+	char packed[64];
+	int packed_size;
+	err = codec_pack(codec, &hello, packed, 4, &packed_size);
+	if (err != TVIO_ERR_BUFFER_TOO_SMALL || packed_size != 16) {
+		printf("FAIL, codec_pack with small buffer err %d size %d\n", err, packed_size);
+		return 1;
+	};
+	err = codec_pack(codec, &hello, packed, sizeof(packed), &packed_size);
+	if (err != 0) {
+		printf("FAIL, codec_pack err %d\n", err);
+		return 1;
+	};
+	err = codec_unpack(codec, packed, packed_size, &unpacked);
+	if (err != 0 || unpacked.Greeting.size != params_size || memcmp(unpacked.Greeting.data, params, params_size) != 0) {
+		printf("FAIL, codec_unpack err %d\n", err);
+		return 1;
+	};
+	hello.Greeting.size = -1;
+	err = codec_pack(codec, &hello, packed, sizeof(packed), &packed_size);
+	if (err != TVIO_ERR_MALFORMED_PARAMETERS) {
+		printf("FAIL, codec_pack with negative size err %d\n", err);
+		return 1;
+	};
+	hello.Greeting.data = NULL;
+	hello.Greeting.size = params_size;
+	err = codec_pack(codec, &hello, packed, sizeof(packed), &packed_size);
+	if (err != TVIO_ERR_MALFORMED_PARAMETERS) {
+		printf("FAIL, codec_pack without data err %d\n", err);
+		return 1;
+	};
+	err = codec_unpack(codec, packed, packed_size - 1, &unpacked);
+	if (err != TVIO_ERR_MALFORMED_PARAMETERS) {
+		printf("FAIL, codec_unpack of truncated data err %d\n", err);
+		return 1;
+	};
+	if (codec_new(DESCRIPTOR, fun, 0, offsets, 2) != TVIO_ERR_INVALID_CODEC) {
+		printf("FAIL, codec_new accepted wrong number of offsets\n");
+		return 1;
+	};
+	err = codec_remove(codec);
+	if (err != 0) {
+		printf("FAIL, codec_remove err %d\n", err);
+		return 1;
+	};
+	struct count {
+		long long N;
+	} count;
+	int count_offsets[1] = {offsetof(struct count, N)};
+	codec = codec_new("function Count(N uint64) ()\n", "Count", 0, count_offsets, 1);
+	if (codec < 0) {
+		printf("FAIL, codec_new for int err %d\n", codec);
+		return 1;
+	};
+	unsigned char max_int[] = {0x81, 0xa1, 'N', 0xcf, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+	err = codec_unpack(codec, max_int, sizeof(max_int), &count);
+	if (err != 0 || count.N != 0x7fffffffffffffffLL) {
+		printf("FAIL, codec_unpack of int64 max err %d value %lld\n", err, count.N);
+		return 1;
+	};
+	unsigned char over_int[] = {0x81, 0xa1, 'N', 0xcf, 0x80, 0, 0, 0, 0, 0, 0, 0};
+	err = codec_unpack(codec, over_int, sizeof(over_int), &count);
+	if (err != TVIO_ERR_MALFORMED_PARAMETERS) {
+		printf("FAIL, codec_unpack of uint64 beyond int64 err %d\n", err);
+		return 1;
+	};
+	codec_remove(codec);
+
+	printf("SUCCESS\n");
+
+	printf("Testing Batch...\n");
+
+	char * batch_funs[2] = {fun, "NoSuchFunction"};
+	int batch_offsets[3] = {0, params_size, params_size};
+	char batch_ids[32];
+	int issued;
+	err = input_call_batch(input, 2, batch_funs, params, batch_offsets, batch_ids, &issued);
+	if (err != TVIO_ERR_INVALID_FUNCTION || issued != 1) {
+		printf("FAIL, call_batch err %d issued %d\n", err, issued);
+		return 1;
+	};
+	int bad_offsets[3] = {0, params_size, 1};
+	err = input_call_batch(input, 2, batch_funs, params, bad_offsets, batch_ids, &issued);
+	if (err != TVIO_ERR_MALFORMED_PARAMETERS || issued != 0) {
+		printf("FAIL, call_batch with decreasing offsets err %d\n", err);
+		return 1;
+	};
+	err = input_call_batch(input, -1, batch_funs, params, batch_offsets, batch_ids, &issued);
+	if (err != TVIO_ERR_MALFORMED_PARAMETERS) {
+		printf("FAIL, call_batch with negative n err %d\n", err);
+		return 1;
+	};
+	// Serve the first CALL of the batch, so it does not linger.
+	err = output_request_wait(output, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, batch request hasnt arrived\n");
+		return 1;
+	};
+	err = output_request_take(output, &req_uuid, &rfun, &rparams, &rparams_size);
+	if (err != 0) {
+		printf("FAIL, request_take err %d\n", err);
+		return 1;
+	};
+	err = output_reply(output, req_uuid, resparams, resparams_size);
+	free(req_uuid);
+	if (err != 0) {
+		printf("FAIL, reply err %d\n", err);
+		return 1;
+	};
+	err = input_completions_wait(input, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, no completion for batch\n");
+		return 1;
+	};
+	err = input_completions_take(input, 1, completion_ids, completion_offsets, &completion_params, &completions);
+	if (err != 0 || completions != 1 || memcmp(completion_ids, batch_ids, 16) != 0) {
+		printf("FAIL, batch completion err %d\n", err);
+		return 1;
+	};
+	free(completion_params);
+
+	printf("SUCCESS\n");
+
+	printf("Testing Serve...\n");
+
+	err = output_serve(output, 4, serve_echo, NULL);
+	if (err != 0) {
+		printf("FAIL, output_serve err %d\n", err);
+		return 1;
+	};
+	err = input_call(input, fun, params, params_size, &uuid, &uuid_size);
+	if (err != 0) {
+		printf("FAIL input call err %d\n", err);
+		return 1;
+	};
+	err = input_completions_wait(input, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, served request was not replied\n");
+		return 1;
+	};
+	err = input_completions_take(input, 1, completion_ids, completion_offsets, &completion_params, &completions);
+	if (err != 0 || completions != 1 || completion_offsets[1] != params_size) {
+		printf("FAIL, completions_take err %d\n", err);
+		return 1;
+	};
+	free(completion_params);
+	err = output_serve(output, 0, NULL, NULL);
+	if (err != 0) {
+		printf("FAIL, output_serve stop err %d\n", err);
+		return 1;
+	};
+
+	printf("SUCCESS\n");
+
+	printf("Testing Queue Overflow...\n");
+
+	if (!wait_queue(output, 0, 0, 0)) {
+		printf("FAIL, request queue is not empty\n");
+		return 1;
+	}
+	err = output_queue_set(output, 2, TVIO_QUEUE_DROP_OLDEST);
+	if (err != 0 || !trigger_abc(input) || !wait_queue(output, 2, 1, 0) ||
+	    !take_request(output, "B") || !take_request(output, "C")) {
+		printf("FAIL, DROP_OLDEST err %d\n", err);
+		return 1;
+	}
+	err = output_queue_set(output, 2, TVIO_QUEUE_DROP_NEWEST);
+	if (err != 0 || !trigger_abc(input) || !wait_queue(output, 2, 2, 0) ||
+	    !take_request(output, "A") || !take_request(output, "B")) {
+		printf("FAIL, DROP_NEWEST err %d\n", err);
+		return 1;
+	}
+	err = output_queue_set(output, 2, TVIO_QUEUE_REJECT);
+	if (err != 0 || !trigger_abc(input) || !wait_queue(output, 2, 2, 1) ||
+	    !take_request(output, "A") || !take_request(output, "B")) {
+		printf("FAIL, REJECT err %d\n", err);
+		return 1;
+	}
+	// The third request waits for space instead of being dropped.
+	err = output_queue_set(output, 2, TVIO_QUEUE_BLOCK);
+	if (err != 0 || !trigger_abc(input) || !wait_queue(output, 2, 2, 1)) {
+		printf("FAIL, BLOCK err %d\n", err);
+		return 1;
+	}
+	usleep(100000);
+	if (!wait_queue(output, 2, 2, 1) || !take_request(output, "A") || !wait_queue(output, 2, 2, 1) ||
+	    !take_request(output, "B") || !take_request(output, "C")) {
+		printf("FAIL, BLOCK did not hold the request back\n");
+		return 1;
+	}
+	// Dropped or rejected CALLs of an input in this process fail.
+	if (local_calls) {
+		char *call_a, *call_b;
+		int call_size;
+		err = output_queue_set(output, 1, TVIO_QUEUE_DROP_OLDEST);
+		if (err != 0 || input_call(input, fun, "A", 1, &call_a, &call_size) != 0 ||
+		    input_call(input, fun, "B", 1, &call_b, &call_size) != 0 || !wait_queue(output, 1, 3, 1)) {
+			printf("FAIL, CALL with DROP_OLDEST err %d\n", err);
+			return 1;
+		}
+		err = input_call_result_params(input, call_a, &resultparams, &resultparams_size);
+		if (err != TVIO_ERR_QUEUE_FULL || !take_request(output, "B")) {
+			printf("FAIL, dropped CALL err %d\n", err);
+			return 1;
+		}
+		free(call_a);
+		free(call_b);
+		err = output_queue_set(output, 1, TVIO_QUEUE_DROP_NEWEST);
+		if (err != 0 || input_call(input, fun, "A", 1, &call_a, &call_size) != 0) {
+			printf("FAIL, CALL with DROP_NEWEST err %d\n", err);
+			return 1;
+		}
+		err = input_call(input, fun, "B", 1, &call_b, &call_size);
+		if (err != TVIO_ERR_QUEUE_FULL || !wait_queue(output, 1, 4, 1) || !take_request(output, "A")) {
+			printf("FAIL, dropped new CALL err %d\n", err);
+			return 1;
+		}
+		free(call_a);
+		err = output_queue_set(output, 1, TVIO_QUEUE_REJECT);
+		if (err != 0 || input_call(input, fun, "A", 1, &call_a, &call_size) != 0) {
+			printf("FAIL, CALL with REJECT err %d\n", err);
+			return 1;
+		}
+		err = input_call(input, fun, "B", 1, &call_b, &call_size);
+		if (err != TVIO_ERR_QUEUE_FULL || !wait_queue(output, 1, 4, 2) || !take_request(output, "A")) {
+			printf("FAIL, rejected CALL err %d\n", err);
+			return 1;
+		}
+		free(call_a);
+	}
+	err = output_queue_set(output, 0, TVIO_QUEUE_BLOCK);
+	if (err != 0) {
+		printf("FAIL, unbound queue err %d\n", err);
+		return 1;
+	}
+
+	printf("SUCCESS\n");
+
+	printf("Testing Request Handler...\n");
+
+	err = output_set_request_handler(output, handle_echo, &handled);
+	if (err != 0) {
+		printf("FAIL, set_request_handler err %d\n", err);
+		return 1;
+	};
+	err = input_call(input, fun, params, params_size, &uuid, &uuid_size);
+	if (err != 0) {
+		printf("FAIL input call err %d\n", err);
+		return 1;
+	};
+	err = input_call_result_wait(input, uuid, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, handled request was not replied\n");
+		return 1;
+	};
+	err = input_call_result_params(input, uuid, &resultparams, &resultparams_size);
+	if (err != 0 || handled != 1 || resultparams_size != params_size || memcmp(resultparams, params, params_size) != 0) {
+		printf("FAIL, handler called %d times, result err %d\n", handled, err);
+		return 1;
+	};
+	free(resultparams);
+	free(uuid);
+	err = output_request_available(output, &is);
+	if (err != 0 || is != 0) {
+		printf("FAIL, handled request was queued\n");
+		return 1;
+	};
+	err = output_set_request_handler(output, NULL, NULL);
+	if (err != 0) {
+		printf("FAIL, unset request_handler err %d\n", err);
+		return 1;
+	};
+
+	printf("SUCCESS\n");
+
+	printf("Testing Binary IDs...\n");
+
+	unsigned char bin_id[16], bin_req_id[16];
+	err = input_call_bin(input, fun, params, params_size, bin_id);
+	if (err != 0) {
+		printf("FAIL, call_bin err %d\n", err);
+		return 1;
+	};
+	err = output_request_wait(output, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, binary request hasnt arrived\n");
+		return 1;
+	};
+	err = output_request_id_bin(output, bin_req_id);
+	if (err != 0 || memcmp(bin_id, bin_req_id, 16) != 0) {
+		printf("FAIL, request_id_bin err %d\n", err);
+		return 1;
+	};
+	err = output_request_function_bin(output, bin_req_id, &rfun, &is);
+	if (err != 0 || strcmp(rfun, fun) != 0) {
+		printf("FAIL, request_function_bin err %d\n", err);
+		return 1;
+	};
+	free(rfun);
+	err = output_request_params_bin(output, bin_req_id, &rparams, &rparams_size);
+	if (err != 0 || rparams_size != params_size || memcmp(rparams, params, params_size) != 0) {
+		printf("FAIL, request_params_bin err %d\n", err);
+		return 1;
+	};
+	free(rparams);
+	err = output_reply_bin(output, bin_req_id, resparams, resparams_size);
+	if (err != 0) {
+		printf("FAIL, reply_bin err %d\n", err);
+		return 1;
+	};
+	err = input_call_result_wait_bin(input, bin_id, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, binary result hasnt arrived\n");
+		return 1;
+	};
+	err = input_call_result_params_bin(input, bin_id, &resultparams, &resultparams_size);
+	if (err != 0 || resultparams_size != resparams_size || memcmp(resultparams, resparams, resparams_size) != 0) {
+		printf("FAIL, call_result_params_bin err %d\n", err);
+		return 1;
+	};
+	free(resultparams);
+
+	printf("SUCCESS\n");
+
+	printf("Testing Nocopy...\n");
+
+	char nocopy_buf[10];
+	int nocopy_userdata;
+	memcpy(nocopy_buf, resparams, resparams_size);
+	err = input_call(input, fun, params, params_size, &uuid, &uuid_size);
+	if (err != 0) {
+		printf("FAIL input call err %d\n", err);
+		return 1;
+	};
+	err = output_request_wait(output, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, request hasnt arrived\n");
+		return 1;
+	};
+	err = output_request_take(output, &req_uuid, &rfun, &rparams, &rparams_size);
+	if (err != 0) {
+		printf("FAIL, request_take err %d\n", err);
+		return 1;
+	};
+	err = output_reply_nocopy(output, req_uuid, nocopy_buf, resparams_size, release_count, &nocopy_userdata);
+	if (err != 0) {
+		printf("FAIL, reply_nocopy err %d\n", err);
+		return 1;
+	};
+	if (released != 1 || released_data != nocopy_buf || released_userdata != &nocopy_userdata) {
+		printf("FAIL, reply_nocopy released %d times\n", released);
+		return 1;
+	};
+	// The buffer is the host's again, the result must not change with it.
+	memset(nocopy_buf, 0, sizeof(nocopy_buf));
+	err = input_call_result_wait(input, uuid, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, nocopy result hasnt arrived\n");
+		return 1;
+	};
+	err = input_call_result_params(input, uuid, &resultparams, &resultparams_size);
+	if (err != 0 || resultparams_size != resparams_size || memcmp(resultparams, resparams, resparams_size) != 0) {
+		printf("FAIL, nocopy result err %d\n", err);
+		return 1;
+	};
+	free(resultparams);
+	free(uuid);
+
+	// Release also fires when the reply fails.
+	err = output_reply_nocopy(output, req_uuid, nocopy_buf, resparams_size, release_count, &nocopy_userdata);
+	free(req_uuid);
+	if (err != TVIO_ERR_INVALID_REQUEST_ID || released != 2) {
+		printf("FAIL, failed reply_nocopy err %d, released %d times\n", err, released);
+		return 1;
+	};
+
+	printf("SUCCESS\n");
+
+	printf("Testing Stats...\n");
+
+	// Without listening, the reply counts as a single received result.
+	err = input_listen_stop(input, fun);
+	if (err != 0) {
+		printf("FAIL, listen_stop err %d\n", err);
+		return 1;
+	};
+	tvio_input_statistics istats_before, istats;
+	tvio_output_statistics ostats_before, ostats;
+	if (input_stats(input, &istats_before) != 0 || output_stats(output, &ostats_before) != 0) {
+		printf("FAIL, stats failed\n");
+		return 1;
+	}
+	err = input_call(input, fun, params, params_size, &uuid, &uuid_size);
+	if (err != 0) {
+		printf("FAIL input call err %d\n", err);
+		return 1;
+	};
+	err = output_request_wait(output, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, request hasnt arrived\n");
+		return 1;
+	};
+	err = output_request_take(output, &req_uuid, &rfun, &rparams, &rparams_size);
+	if (err != 0) {
+		printf("FAIL, request_take err %d\n", err);
+		return 1;
+	};
+	if (output_stats(output, &ostats) != 0 || ostats.request_cache_depth != ostats_before.request_cache_depth + 1) {
+		printf("FAIL, request_cache_depth is %llu\n", ostats.request_cache_depth);
+		return 1;
+	}
+	err = output_reply(output, req_uuid, resparams, resparams_size);
+	free(req_uuid);
+	if (err != 0) {
+		printf("FAIL, reply err %d\n", err);
+		return 1;
+	};
+	err = input_call_result_wait(input, uuid, 5000, &is);
+	if (err != 0 || is != 1) {
+		printf("FAIL, result hasnt arrived\n");
+		return 1;
+	};
+	if (input_stats(input, &istats) != 0 || output_stats(output, &ostats) != 0) {
+		printf("FAIL, stats failed\n");
+		return 1;
+	}
+	if (istats.requests_sent != istats_before.requests_sent + 1 || istats.bytes_out != istats_before.bytes_out + params_size ||
+	    istats.results_received != istats_before.results_received + 1 || istats.bytes_in != istats_before.bytes_in + resparams_size ||
+	    istats.results_depth != istats_before.results_depth + 1 || istats.call_time.count != istats_before.call_time.count + 1) {
+		printf("FAIL, input stats sent %llu received %llu\n", istats.requests_sent - istats_before.requests_sent,
+		       istats.results_received - istats_before.results_received);
+		return 1;
+	}
+	if (ostats.requests_received != ostats_before.requests_received + 1 || ostats.bytes_in != ostats_before.bytes_in + params_size ||
+	    ostats.results_sent != ostats_before.results_sent + 1 || ostats.bytes_out != ostats_before.bytes_out + resparams_size ||
+	    ostats.request_cache_depth != ostats_before.request_cache_depth || ostats.queue_time.count != ostats_before.queue_time.count + 1) {
+		printf("FAIL, output stats received %llu sent %llu\n", ostats.requests_received - ostats_before.requests_received,
+		       ostats.results_sent - ostats_before.results_sent);
+		return 1;
+	}
+	err = input_call_result_params(input, uuid, &resultparams, &resultparams_size);
+	if (err != 0 || input_stats(input, &istats) != 0 || istats.results_depth != istats_before.results_depth) {
+		printf("FAIL, results_depth after retrieval err %d\n", err);
+		return 1;
+	};
+	free(resultparams);
+	free(uuid);
+
+	printf("SUCCESS\n");
+
+	printf("Testing Removal...\n");
+
+	// A CALL to an output in this process fails when the output goes away.
+	if (local_calls) {
+		err = input_call(input, fun, params, params_size, &uuid, &uuid_size);
+		if (err != 0) {
+			printf("FAIL input call err %d\n", err);
+			return 1;
+		};
+	};
 
 	err = output_remove(output);
 	if (err != 0) {
 		printf("FAIL, remove_input err not 0\n");
 		return 1;
 	};
+
+	if (local_calls) {
+		err = input_call_result_params(input, uuid, &resultparams, &resultparams_size);
+		if (err != TVIO_ERR_INVALID_OUTPUT) {
+			printf("FAIL, pending local CALL did not fail, err %d\n", err);
+			return 1;
+		};
+		free(uuid);
+	};
+
+	err = input_remove(input);
+	if (err != 0) {
+		printf("FAIL, remove_input err %d\n", err);
+		return 1;
+	};
 	printf("SUCCESS\n");
 	return 0;
 }